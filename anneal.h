@@ -0,0 +1,147 @@
+#ifndef ANNEAL_H
+#define ANNEAL_H
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+/**
+* Settings for the simulated annealing loop shared by the floorplan engines.
+* A limit of 0 means unlimited.
+*/
+struct AnnealSchedule
+{
+    AnnealSchedule() :
+        coolingRate(0.9), movesPerTemperature(0), minTemperature(1e-3),
+        maxMoves(0), timeLimitMs(0), start(std::chrono::steady_clock::now())
+    {
+
+    }
+
+    double coolingRate;
+    // moves tried at each temperature, 0 picks 2 per module
+    int movesPerTemperature;
+    double minTemperature;
+    long long maxMoves;
+    long long timeLimitMs;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+* Cost of a packing with a width x height bounding box, relative to the area
+* of the modules themselves (so a perfect packing costs 1). If an outline is
+* given (both sides positive) every unit the box sticks out of it on either
+* side is charged heavily, steering the search into fixed-outline packings.
+*/
+inline double packingCost(long long width, long long height, long long moduleArea,
+                          int outlineWidth, int outlineHeight)
+{
+    double cost = (double)width * height / (moduleArea > 0 ? moduleArea : 1);
+    if(outlineWidth > 0 && outlineHeight > 0)
+    {
+        if(width > outlineWidth)
+        {
+            cost += 10.0 * (width - outlineWidth) / outlineWidth;
+        }
+        if(height > outlineHeight)
+        {
+            cost += 10.0 * (height - outlineHeight) / outlineHeight;
+        }
+    }
+    return cost;
+}
+
+/**
+* Simulated annealing over any floorplan representation providing
+*     int size() const;             number of modules
+*     double cost() const;          cost of the current floorplan
+*     void perturb(std::mt19937&);  apply a random move and re-evaluate
+*     void undo();                  revert the last move
+*     void keepBest();              remember the current floorplan
+*     void restoreBest();           go back to the remembered one
+* The plan is left holding the best floorplan seen, whose cost is returned.
+* If stopped is given it tells whether a limit ended the run before it had
+* cooled down.
+*/
+template <typename Plan>
+double anneal(Plan& plan, const AnnealSchedule& schedule, std::mt19937& rng, bool* stopped = NULL)
+{
+    if(stopped != NULL)
+    {
+        *stopped = false;
+    }
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    int perStage = schedule.movesPerTemperature > 0 ? schedule.movesPerTemperature : 2 * plan.size();
+    double current = plan.cost();
+    double best = current;
+    plan.keepBest();
+
+    //start hot enough to accept an average uphill move half of the time;
+    //much hotter and the moves just scramble the floorplan
+    double uphill = 0;
+    int samples = 0;
+    for (int i = 0; i < plan.size() + 10; i++)
+    {
+        plan.perturb(rng);
+        double delta = plan.cost() - current;
+        if(delta > 0)
+        {
+            uphill += delta;
+            samples++;
+        }
+        plan.undo();
+    }
+    double temperature = samples > 0 ? -(uphill / samples) / std::log(0.5) : 1.0;
+
+    long long moves = 0;
+    while(temperature > schedule.minTemperature)
+    {
+        for (int i = 0; i < perStage; i++)
+        {
+            if(schedule.maxMoves > 0 && moves >= schedule.maxMoves)
+            {
+                if(stopped != NULL)
+                {
+                    *stopped = true;
+                }
+                plan.restoreBest();
+                return best;
+            }
+            moves++;
+            //the clock is only read every 256 moves
+            if(schedule.timeLimitMs > 0 && (moves & 255) == 0 &&
+               std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - schedule.start).count() >= schedule.timeLimitMs)
+            {
+                if(stopped != NULL)
+                {
+                    *stopped = true;
+                }
+                plan.restoreBest();
+                return best;
+            }
+            plan.perturb(rng);
+            double next = plan.cost();
+            double delta = next - current;
+            if(delta <= 0 || coin(rng) < std::exp(-delta / temperature))
+            {
+                current = next;
+                if(current < best)
+                {
+                    best = current;
+                    plan.keepBest();
+                }
+            }
+            else
+            {
+                plan.undo();
+            }
+        }
+        temperature *= schedule.coolingRate;
+    }
+    plan.restoreBest();
+    return best;
+}
+
+#endif
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "batch.h"
+#include "instance.h"
+#include "mappedfile.h"
+#include "binformat.h"
+#include "cache.h"
+
+using namespace std;
+
+// One instance of a batch. Jobs read from files carry the paths and are
+// loaded by the worker that takes them; jobs from a stream carry the
+// instance itself and leave their answer in text.
+struct BatchJob
+{
+    BatchJob() : loaded(false), binary(false), ms(0)
+    {
+
+    }
+
+    string name;
+    string inputPath;
+    string outputPath;
+    Instance instance;
+    bool loaded;
+    // the input was in the binary format, and so the answer is
+    bool binary;
+    string text;
+    string status;
+    long long ms;
+};
+
+// One word or two on how a solve went, for the report
+string summarize(const SolverOptions& opts, const SolveResult& result, const Instance& instance)
+{
+    if(opts.engine != "grid")
+    {
+        return result.width <= instance.width && result.height <= instance.height ? "fits" : "exceeds";
+    }
+    if(!result.reason.empty())
+    {
+        return "infeasible";
+    }
+    if(result.complete)
+    {
+        return (opts.strip || opts.minArea) && !result.optimal ? "best found" : "solved";
+    }
+    return result.exhausted ? "budget exhausted" : "no solution";
+}
+
+void writeAnswer(std::ostream& os, const BatchJob& job, const SolverOptions& opts, const SolveResult& result)
+{
+    if(job.binary)
+    {
+        writeBinaryResult(os, job.instance, opts, result);
+    }
+    else
+    {
+        writeResult(os, job.instance, opts, result);
+    }
+}
+
+void runJob(BatchJob& job, const SolverOptions& opts, ResultCache* cache)
+{
+    if(!job.loaded)
+    {
+        string error;
+        if(!loadInstance(job.inputPath, job.instance, job.binary, error))
+        {
+            job.status = "invalid input file " + error;
+            return;
+        }
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    SolveResult result = solveCached(job.instance, opts, cache);
+    job.ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    job.status = summarize(opts, result, job.instance);
+    if(job.outputPath.empty())
+    {
+        ostringstream os;
+        writeAnswer(os, job, opts, result);
+        job.text = os.str();
+    }
+    else
+    {
+        ofstream ofile(job.outputPath.c_str(), ios::binary);
+        writeAnswer(ofile, job, opts, result);
+    }
+    //the pieces are not needed any more, and a stream may hold millions
+    vector<Rectangle>().swap(job.instance.pieces);
+}
+
+// Body of one pool thread: takes the next unclaimed job until none are left
+void batchWorker(vector<BatchJob>& jobs, const SolverOptions& opts, ResultCache* cache, std::atomic<size_t>& next)
+{
+    for (size_t i = next++; i < jobs.size(); i = next++)
+    {
+        runJob(jobs[i], opts, cache);
+    }
+}
+
+string baseName(const string& path)
+{
+    size_t slash = path.find_last_of('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+bool isDirectory(const string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+// Adds a job for every regular file in dir, in name order
+bool listDirectory(const string& dir, const string& destination, vector<BatchJob>& jobs)
+{
+    DIR* handle = opendir(dir.c_str());
+    if(handle == NULL)
+    {
+        return false;
+    }
+    vector<string> names;
+    for (struct dirent* entry = readdir(handle); entry != NULL; entry = readdir(handle))
+    {
+        string name = entry->d_name;
+        if(name[0] != '.' && !isDirectory(dir + "/" + name))
+        {
+            names.push_back(name);
+        }
+    }
+    closedir(handle);
+    sort(names.begin(), names.end());
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        BatchJob job;
+        job.name = names[i];
+        job.inputPath = dir + "/" + names[i];
+        job.outputPath = destination + "/" + names[i];
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+bool runBatch(const std::string& source, const std::string& destination, const SolverOptions& opts,
+              int threads, std::ostream& report, ResultCache* cache)
+{
+    vector<BatchJob> jobs;
+    bool stream = false;
+    bool binary = false;
+    if(isDirectory(source))
+    {
+        if(!listDirectory(source, destination, jobs))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        MappedFile file;
+        if(!file.open(source))
+        {
+            return false;
+        }
+        const char* begin = file.data();
+        const char* end = begin + file.size();
+        const char* first = begin;
+        while(first != end && (*first == ' ' || *first == '\t' || *first == '\r' || *first == '\n'))
+        {
+            first++;
+        }
+        binary = isBinaryInstance(begin, end);
+        stream = binary || isInstanceHeader(string(first, std::find(first, end, '\n')));
+        if(binary)
+        {
+            BinaryInstanceReader reader(begin, end);
+            BatchJob job;
+            job.loaded = true;
+            job.binary = true;
+            while(reader.next(job.instance))
+            {
+                ostringstream name;
+                name << "instance " << jobs.size() + 1;
+                job.name = name.str();
+                jobs.push_back(job);
+            }
+            if(!reader.error().empty())
+            {
+                report << source << ": " << reader.error() << endl;
+                return false;
+            }
+        }
+        else if(stream)
+        {
+            InstanceParser parser(begin, end);
+            BatchJob job;
+            job.loaded = true;
+            while(parser.next(job.instance))
+            {
+                ostringstream name;
+                name << "instance " << jobs.size() + 1;
+                job.name = name.str();
+                jobs.push_back(job);
+            }
+            if(!parser.error().empty())
+            {
+                report << source << ":" << parser.error() << endl;
+                return false;
+            }
+        }
+        else
+        {
+            for (const char* line = begin; line != end; )
+            {
+                const char* next = std::find(line, end, '\n');
+                string path(line, next);
+                line = next == end ? end : next + 1;
+                size_t last = path.find_last_not_of(" \t\r");
+                if(last == string::npos)
+                {
+                    continue;
+                }
+                BatchJob job;
+                job.inputPath = path.substr(0, last + 1);
+                job.name = baseName(job.inputPath);
+                job.outputPath = destination + "/" + job.name;
+                jobs.push_back(job);
+            }
+        }
+    }
+    if(!stream && !isDirectory(destination) && mkdir(destination.c_str(), 0777) != 0)
+    {
+        return false;
+    }
+    ofstream ofile;
+    if(stream)
+    {
+        ofile.open(destination.c_str(), ios::binary);
+        if(ofile.fail())
+        {
+            return false;
+        }
+    }
+
+    if(threads <= 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<size_t>(threads, std::max<size_t>(jobs.size(), 1));
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        workers.push_back(std::thread(batchWorker, std::ref(jobs), std::cref(opts), cache, std::ref(next)));
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i].join();
+    }
+    long long total = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        //binary answers carry their own headers, so they are simply concatenated
+        if(binary)
+        {
+            ofile << jobs[i].text;
+        }
+        else if(stream)
+        {
+            writeStreamAnswer(ofile, i, jobs[i].text);
+        }
+        report << jobs[i].name << ": " << jobs[i].status << ", " << jobs[i].ms << " ms" << endl;
+    }
+    report << jobs.size() << " instances in " << total << " ms on " << threads << " threads" << endl;
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <iostream>
+#include <string>
+#include "solver.h"
+#include "cache.h"
+
+/**
+* Solves many instances in one process on a fixed pool of threads threads
+* (0 picks one per core). source is either a directory, whose files are
+* each an input; a file listing one input path per line; or a stream of
+* instances written back to back. For directories and lists every answer
+* goes to a file of the same name in the destination directory, which is
+* created if needed; for a stream all answers go to the destination file,
+* in input order, each after an "Instance k" line. Inputs in the binary
+* format of binformat.h get binary answers (a binary stream's answers are
+* written back to back with no "Instance k" lines). Whatever the source, one
+* "name: status, time" line per instance (solve time only) and a total are
+* written to report in input order. With a cache, instances it already
+* holds are answered from it and the others are added. Returns false if
+* the source or the destination cannot be opened.
+*/
+bool runBatch(const std::string& source, const std::string& destination, const SolverOptions& opts,
+              int threads, std::ostream& report, ResultCache* cache = NULL);
+
+#endif
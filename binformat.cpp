@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "binformat.h"
+#include "mappedfile.h"
+
+using namespace std;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the binary formats are written in host byte order, which must be little-endian"
+#endif
+
+static_assert(sizeof(Rectangle) == 3 * sizeof(int32_t), "Rectangle must match the binary piece record");
+static_assert(sizeof(BinaryInstanceHeader) == 24, "binary instance header must be packed");
+static_assert(sizeof(BinarySolutionHeader) == 32, "binary solution header must be packed");
+static_assert(sizeof(BinaryPlacement) == 16, "binary placement must be packed");
+
+bool isBinaryInstance(const char* begin, const char* end)
+{
+    return end - begin >= 4 && memcmp(begin, BINARY_INSTANCE_MAGIC, 4) == 0;
+}
+
+bool isBinarySolution(const char* begin, const char* end)
+{
+    return end - begin >= 4 && memcmp(begin, BINARY_SOLUTION_MAGIC, 4) == 0;
+}
+
+bool rectangleIdLess(const Rectangle& a, const Rectangle& b)
+{
+    return a.ID < b.ID;
+}
+
+// The pieces of instance in ID order, for findPiece()
+vector<Rectangle> piecesById(const Instance& instance)
+{
+    vector<Rectangle> sorted(instance.pieces);
+    sort(sorted.begin(), sorted.end(), rectangleIdLess);
+    return sorted;
+}
+
+const Rectangle* findPiece(const vector<Rectangle>& sorted, int ID)
+{
+    Rectangle key = {ID, 0, 0};
+    vector<Rectangle>::const_iterator it = lower_bound(sorted.begin(), sorted.end(), key, rectangleIdLess);
+    return it != sorted.end() && it->ID == ID ? &*it : NULL;
+}
+
+BinaryInstanceReader::BinaryInstanceReader(const char* begin, const char* end, size_t offset) :
+    begin_(begin), pos_(begin), end_(end), offset_(offset), truncated_(false)
+{
+
+}
+
+bool BinaryInstanceReader::next(Instance& instance)
+{
+    if(pos_ == end_)
+    {
+        return false;
+    }
+    BinaryInstanceHeader header;
+    if((size_t)(end_ - pos_) < sizeof(header))
+    {
+        return fail("truncated instance header", true);
+    }
+    memcpy(&header, pos_, sizeof(header));
+    if(memcmp(header.magic, BINARY_INSTANCE_MAGIC, 4) != 0)
+    {
+        return fail("not a binary instance");
+    }
+    if(header.version != BINARY_FORMAT_VERSION)
+    {
+        return fail("unsupported binary format version");
+    }
+    if(header.width < 1 || header.height < 1)
+    {
+        return fail("board side too small");
+    }
+    if(header.count > (size_t)(end_ - pos_ - sizeof(header)) / sizeof(Rectangle))
+    {
+        return fail("truncated piece records", true);
+    }
+    const char* records = pos_ + sizeof(header);
+    //the records have the layout of Rectangle, so they are copied in one block
+    instance.width = header.width;
+    instance.height = header.height;
+    instance.pieces.resize(header.count);
+    if(header.count > 0)
+    {
+        memcpy(&instance.pieces[0], records, header.count * sizeof(Rectangle));
+    }
+    for (size_t i = 0; i < instance.pieces.size(); i++)
+    {
+        if(instance.pieces[i].length < 1 || instance.pieces[i].height < 1)
+        {
+            pos_ = records + i * sizeof(Rectangle);
+            return fail("piece side too small");
+        }
+    }
+    pos_ = records + header.count * sizeof(Rectangle);
+    return true;
+}
+
+bool BinaryInstanceReader::atEnd() const
+{
+    return pos_ == end_;
+}
+
+const std::string& BinaryInstanceReader::error() const
+{
+    return error_;
+}
+
+bool BinaryInstanceReader::truncated() const
+{
+    return truncated_;
+}
+
+const char* BinaryInstanceReader::position() const
+{
+    return pos_;
+}
+
+bool BinaryInstanceReader::fail(const std::string& message, bool truncated)
+{
+    truncated_ = truncated;
+    ostringstream os;
+    os << "byte " << offset_ + (pos_ - begin_) << ": " << message;
+    error_ = os.str();
+    return false;
+}
+
+void writeBinaryInstance(std::ostream& os, const Instance& instance)
+{
+    BinaryInstanceHeader header;
+    memcpy(header.magic, BINARY_INSTANCE_MAGIC, 4);
+    header.version = BINARY_FORMAT_VERSION;
+    header.width = instance.width;
+    header.height = instance.height;
+    header.count = instance.pieces.size();
+    header.reserved = 0;
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if(!instance.pieces.empty())
+    {
+        os.write(reinterpret_cast<const char*>(&instance.pieces[0]), instance.pieces.size() * sizeof(Rectangle));
+    }
+}
+
+void writeBinaryResult(std::ostream& os, const Instance& instance, const SolverOptions& opts,
+                       const SolveResult& result)
+{
+    BinarySolutionHeader header;
+    memcpy(header.magic, BINARY_SOLUTION_MAGIC, 4);
+    header.version = BINARY_FORMAT_VERSION;
+    header.width = result.width;
+    header.height = result.height;
+    header.count = result.placements.size();
+    header.flags = (result.complete ? SOLUTION_COMPLETE : 0) | (result.exhausted ? SOLUTION_EXHAUSTED : 0) |
+                   (result.optimal ? SOLUTION_OPTIMAL : 0);
+    header.mode = outputMode(opts);
+    header.reasonLength = result.reason.size();
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    vector<Rectangle> sorted = piecesById(instance);
+    vector<BinaryPlacement> records(result.placements.size());
+    for (size_t i = 0; i < result.placements.size(); i++)
+    {
+        const Placement& p = result.placements[i];
+        const Rectangle* piece = findPiece(sorted, p.ID);
+        BinaryPlacement record = {p.ID, p.x, p.y, piece != NULL && piece->length != p.length};
+        records[i] = record;
+    }
+    if(!records.empty())
+    {
+        os.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(BinaryPlacement));
+    }
+    const char padding[4] = {0, 0, 0, 0};
+    os.write(result.reason.data(), result.reason.size());
+    os.write(padding, (4 - result.reason.size() % 4) % 4);
+}
+
+BinarySolutionReader::BinarySolutionReader(const char* begin, const char* end) :
+    begin_(begin), pos_(begin), end_(end)
+{
+
+}
+
+bool BinarySolutionReader::next(const Instance& instance, SolveResult& result, OutputMode& mode)
+{
+    if(pos_ == end_)
+    {
+        return false;
+    }
+    BinarySolutionHeader header;
+    if((size_t)(end_ - pos_) < sizeof(header))
+    {
+        return fail("truncated solution header");
+    }
+    memcpy(&header, pos_, sizeof(header));
+    if(memcmp(header.magic, BINARY_SOLUTION_MAGIC, 4) != 0)
+    {
+        return fail("not a binary solution");
+    }
+    if(header.version != BINARY_FORMAT_VERSION)
+    {
+        return fail("unsupported binary format version");
+    }
+    if(header.mode > OUTPUT_ENGINE)
+    {
+        return fail("unknown solution mode");
+    }
+    size_t reasonBytes = (header.reasonLength + 3) / 4 * 4;
+    size_t left = end_ - pos_ - sizeof(header);
+    if(header.count > left / sizeof(BinaryPlacement) ||
+       reasonBytes > left - header.count * sizeof(BinaryPlacement))
+    {
+        return fail("truncated placement records");
+    }
+    mode = static_cast<OutputMode>(header.mode);
+    result = SolveResult();
+    result.width = header.width;
+    result.height = header.height;
+    result.complete = (header.flags & SOLUTION_COMPLETE) != 0;
+    result.exhausted = (header.flags & SOLUTION_EXHAUSTED) != 0;
+    result.optimal = (header.flags & SOLUTION_OPTIMAL) != 0;
+
+    vector<Rectangle> sorted = piecesById(instance);
+    const char* records = pos_ + sizeof(header);
+    result.placements.resize(header.count);
+    for (size_t i = 0; i < header.count; i++)
+    {
+        BinaryPlacement record;
+        memcpy(&record, records + i * sizeof(record), sizeof(record));
+        const Rectangle* piece = findPiece(sorted, record.ID);
+        if(piece == NULL)
+        {
+            pos_ = records + i * sizeof(record);
+            return fail("placement of a piece the instance does not have");
+        }
+        Placement p = {record.ID, record.x, record.y,
+                       record.rotated ? piece->height : piece->length,
+                       record.rotated ? piece->length : piece->height};
+        result.placements[i] = p;
+    }
+    const char* reason = records + header.count * sizeof(BinaryPlacement);
+    result.reason.assign(reason, header.reasonLength);
+    pos_ = reason + reasonBytes;
+    return true;
+}
+
+bool BinarySolutionReader::atEnd() const
+{
+    return pos_ == end_;
+}
+
+const std::string& BinarySolutionReader::error() const
+{
+    return error_;
+}
+
+bool BinarySolutionReader::fail(const std::string& message)
+{
+    ostringstream os;
+    os << "byte " << pos_ - begin_ << ": " << message;
+    error_ = os.str();
+    return false;
+}
+
+// Reads every instance in the file at path, text or binary
+bool loadInstances(const std::string& path, vector<Instance>& instances, std::string& error)
+{
+    MappedFile file;
+    if(!file.open(path))
+    {
+        error = path + ": cannot be read";
+        return false;
+    }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    Instance instance;
+    if(isBinaryInstance(begin, end))
+    {
+        BinaryInstanceReader reader(begin, end);
+        while(reader.next(instance))
+        {
+            instances.push_back(instance);
+        }
+        error = reader.error().empty() ? "" : path + ": " + reader.error();
+    }
+    else
+    {
+        InstanceParser parser(begin, end);
+        while(parser.next(instance))
+        {
+            instances.push_back(instance);
+        }
+        error = parser.error().empty() ? "" : path + ":" + parser.error();
+    }
+    if(error.empty() && instances.empty())
+    {
+        error = path + ": no instance in the file";
+    }
+    return error.empty();
+}
+
+bool convertFile(const std::string& source, const std::string& destination, const std::string& instances,
+                 std::string& error)
+{
+    MappedFile file;
+    if(!file.open(source))
+    {
+        error = source + ": cannot be read";
+        return false;
+    }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    if(isBinarySolution(begin, end))
+    {
+        vector<Instance> solved;
+        if(instances.empty())
+        {
+            error = source + ": a solution needs the instances it solves to be converted";
+            return false;
+        }
+        if(!loadInstances(instances, solved, error))
+        {
+            return false;
+        }
+        BinarySolutionReader reader(begin, end);
+        vector<string> texts;
+        while(!reader.atEnd())
+        {
+            if(texts.size() == solved.size())
+            {
+                error = source + ": more solutions than instances";
+                return false;
+            }
+            SolveResult result;
+            OutputMode mode;
+            if(!reader.next(solved[texts.size()], result, mode))
+            {
+                error = source + ": " + reader.error();
+                return false;
+            }
+            ostringstream text;
+            writeResult(text, solved[texts.size()], mode, result);
+            texts.push_back(text.str());
+        }
+        ofstream ofile(destination.c_str());
+        //a single answer looks just like the output of a single run
+        for (size_t i = 0; i < texts.size(); i++)
+        {
+            if(texts.size() == 1)
+            {
+                ofile << texts[i];
+            }
+            else
+            {
+                writeStreamAnswer(ofile, i, texts[i]);
+            }
+        }
+        return true;
+    }
+
+    vector<Instance> list;
+    if(!loadInstances(source, list, error))
+    {
+        return false;
+    }
+    bool binary = isBinaryInstance(begin, end);
+    ofstream ofile(destination.c_str(), ios::binary);
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        if(binary)
+        {
+            writeInstance(ofile, list[i]);
+        }
+        else
+        {
+            writeBinaryInstance(ofile, list[i]);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,139 @@
+#ifndef BINFORMAT_H
+#define BINFORMAT_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "floorplan.h"
+#include "instance.h"
+#include "solver.h"
+
+/**
+* Binary instance and solution files. All fields are little-endian 32-bit
+* integers and every record starts on a 4-byte boundary, so a mapped file
+* can be read in place. A file may hold any number of instances (or
+* solutions) back to back.
+*
+* An instance is a BinaryInstanceHeader followed by count Rectangle
+* records of ID, length and height, laid out exactly like Rectangle so
+* they are copied into the solver's piece list in one block.
+*
+* A solution is a BinarySolutionHeader, count BinaryPlacement records and
+* reasonLength bytes of text (padded with zeros to a multiple of 4)
+* holding SolveResult::reason. Placements give the corner and whether the
+* piece is turned from the way the instance lists it, so the instance is
+* needed to turn a solution back into text.
+*/
+
+const uint32_t BINARY_FORMAT_VERSION = 1;
+const char BINARY_INSTANCE_MAGIC[4] = {'F', 'P', 'I', 'N'};
+const char BINARY_SOLUTION_MAGIC[4] = {'F', 'P', 'S', 'O'};
+
+struct BinaryInstanceHeader
+{
+    char magic[4];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+// Flags of a solution, matching the fields of SolveResult
+const uint32_t SOLUTION_COMPLETE = 1;
+const uint32_t SOLUTION_EXHAUSTED = 2;
+const uint32_t SOLUTION_OPTIMAL = 4;
+
+struct BinarySolutionHeader
+{
+    char magic[4];
+    uint32_t version;
+    // the board the placements are for, as in SolveResult
+    int32_t width;
+    int32_t height;
+    uint32_t count;
+    uint32_t flags;
+    // the OutputMode the solution was found in, which picks its text form
+    uint32_t mode;
+    uint32_t reasonLength;
+};
+
+struct BinaryPlacement
+{
+    int32_t ID;
+    int32_t x;
+    int32_t y;
+    // 1 if the piece is placed height by length
+    int32_t rotated;
+};
+
+// Checks whether a buffer starts with a binary instance or solution
+bool isBinaryInstance(const char* begin, const char* end);
+bool isBinarySolution(const char* begin, const char* end);
+
+/**
+* Reads binary instances out of a buffer, like InstanceParser does for
+* text, with the same rules: sides must be at least 1, and an instance may
+* have no pieces. Errors give the byte offset of the bad record.
+*/
+class BinaryInstanceReader
+{
+public:
+    // offset is where begin lies in a larger input, for error messages
+    BinaryInstanceReader(const char* begin, const char* end, size_t offset = 0);
+
+    bool next(Instance& instance);
+    bool atEnd() const;
+    const std::string& error() const;
+
+    // As for InstanceParser
+    bool truncated() const;
+    const char* position() const;
+
+private:
+    bool fail(const std::string& message, bool truncated = false);
+
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+    size_t offset_;
+    std::string error_;
+    bool truncated_;
+};
+
+void writeBinaryInstance(std::ostream& os, const Instance& instance);
+
+// Writes the answer for instance as a binary solution
+void writeBinaryResult(std::ostream& os, const Instance& instance, const SolverOptions& opts,
+                       const SolveResult& result);
+
+/**
+* Reads binary solutions out of a buffer and turns each back into the
+* SolveResult and output mode it was written from, given the instance it
+* solves.
+*/
+class BinarySolutionReader
+{
+public:
+    BinarySolutionReader(const char* begin, const char* end);
+
+    bool next(const Instance& instance, SolveResult& result, OutputMode& mode);
+    bool atEnd() const;
+    const std::string& error() const;
+
+private:
+    bool fail(const std::string& message);
+
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+    std::string error_;
+};
+
+// Rewrites every instance or solution in source (text or binary) in the
+// other format; a binary solution needs the instances it solves
+bool convertFile(const std::string& source, const std::string& destination, const std::string& instances,
+                 std::string& error);
+
+#endif
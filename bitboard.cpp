@@ -0,0 +1,39 @@
+#include "bitboard.h"
+
+BitBoard::BitBoard(int width, int height) :
+    width_(width), height_(height), words_((height + 63) / 64), kernels_(&bitKernels())
+{
+    cells_.assign((size_t)width_ * words_, 0);
+}
+
+void BitBoard::prepare(int height)
+{
+    if((int)templates_.size() <= height)
+    {
+        templates_.resize(height + 1);
+    }
+    std::vector<uint64_t>& run = templates_[height];
+    if(!run.empty())
+    {
+        return;
+    }
+    run.assign((height + 63) / 64 + 1, 0);
+    for (int k = 0; k < height / 64; k++)
+    {
+        run[k] = ~(uint64_t)0;
+    }
+    if(height % 64 != 0)
+    {
+        run[height / 64] = ((uint64_t)1 << (height % 64)) - 1;
+    }
+}
+
+int BitBoard::getWidth() const
+{
+    return width_;
+}
+
+int BitBoard::getHeight() const
+{
+    return height_;
+}
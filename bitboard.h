@@ -0,0 +1,154 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include "bitkernels.h"
+
+// Runs of at least this many words are handed to the SIMD kernels
+const int BITBOARD_WIDE_WORDS = 10;
+
+/**
+* A width x height board with one bit per cell, addressed like the quadtree
+* (x in [0, width), y in [0, height)). Column x of the board is a row of
+* 64-bit words holding its cells in y order, so a length x height piece at
+* (x, y) covers the same run of bits [y, y+height) in length consecutive
+* rows.
+*
+* For every piece height in use prepare() builds a template once: the run
+* of height one bits starting at bit 0. Checking a placement ANDs the
+* template, shifted to y, against each row it covers and placing or lifting
+* a piece XORs it in, so no cell is visited on its own. Pieces and
+* orientations with the same height share a template. On tall boards, where
+* a piece spans many words per row, the fully covered words in between go
+* through the SIMD kernels of bitkernels.h.
+*/
+class BitBoard
+{
+public:
+    BitBoard(int width, int height);
+
+    // Builds the template for pieces height cells tall, if not done yet
+    void prepare(int height);
+
+    // Rectangle query and toggle over [x, x+length) x [y, y+height). The
+    // rectangle must lie on the board and prepare(height) must have been
+    // called.
+    bool isEmpty(int x, int y, int length, int height) const;
+    void flip(int x, int y, int length, int height);
+
+    // Single cell access
+    bool get(int x, int y) const;
+    void toggle(int x, int y);
+
+    int getWidth() const;
+    int getHeight() const;
+
+private:
+    // Word k of the template for height, shifted left by shift bits
+    uint64_t mask(const std::vector<uint64_t>& run, int k, int shift) const;
+
+    int width_;
+    int height_;
+    // words per row
+    int words_;
+    std::vector<uint64_t> cells_;
+    const BitKernels* kernels_;
+    // templates_[h] holds the run of h one bits plus a spare zero word for
+    // the bits shifted out of the last one, or is empty if nothing that tall
+    // has been prepared
+    std::vector<std::vector<uint64_t> > templates_;
+};
+
+inline uint64_t BitBoard::mask(const std::vector<uint64_t>& run, int k, int shift) const
+{
+    if(shift == 0)
+    {
+        return run[k];
+    }
+    uint64_t word = run[k] << shift;
+    if(k > 0)
+    {
+        word |= run[k - 1] >> (64 - shift);
+    }
+    return word;
+}
+
+inline bool BitBoard::isEmpty(int x, int y, int length, int height) const
+{
+    const std::vector<uint64_t>& run = templates_[height];
+    int first = y >> 6;
+    int shift = y & 63;
+    int count = (shift + height + 63) >> 6;
+    if(count >= BITBOARD_WIDE_WORDS)
+    {
+        //only the first and last word of each row are partly covered
+        uint64_t head = mask(run, 0, shift);
+        uint64_t tail = mask(run, count - 1, shift);
+        const uint64_t* cell = &cells_[(size_t)x * words_ + first];
+        for (int r = 0; r < length; r++, cell += words_)
+        {
+            if((cell[0] & head) || (cell[count - 1] & tail) || kernels_->anySet(cell + 1, count - 2))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    for (int k = 0; k < count; k++)
+    {
+        uint64_t word = mask(run, k, shift);
+        const uint64_t* cell = &cells_[(size_t)x * words_ + first + k];
+        for (int r = 0; r < length; r++, cell += words_)
+        {
+            if(*cell & word)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+inline void BitBoard::flip(int x, int y, int length, int height)
+{
+    const std::vector<uint64_t>& run = templates_[height];
+    int first = y >> 6;
+    int shift = y & 63;
+    int count = (shift + height + 63) >> 6;
+    if(count >= BITBOARD_WIDE_WORDS)
+    {
+        uint64_t head = mask(run, 0, shift);
+        uint64_t tail = mask(run, count - 1, shift);
+        uint64_t* cell = &cells_[(size_t)x * words_ + first];
+        for (int r = 0; r < length; r++, cell += words_)
+        {
+            cell[0] ^= head;
+            cell[count - 1] ^= tail;
+            kernels_->invert(cell + 1, count - 2);
+        }
+        return;
+    }
+    for (int k = 0; k < count; k++)
+    {
+        uint64_t word = mask(run, k, shift);
+        uint64_t* cell = &cells_[(size_t)x * words_ + first + k];
+        for (int r = 0; r < length; r++, cell += words_)
+        {
+            *cell ^= word;
+        }
+    }
+}
+
+inline bool BitBoard::get(int x, int y) const
+{
+    return (cells_[(size_t)x * words_ + (y >> 6)] >> (y & 63)) & 1;
+}
+
+inline void BitBoard::toggle(int x, int y)
+{
+    cells_[(size_t)x * words_ + (y >> 6)] ^= (uint64_t)1 << (y & 63);
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "bitkernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BITKERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+static bool anySetScalar(const uint64_t* words, size_t count)
+{
+    uint64_t any = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        any |= words[i];
+    }
+    return any != 0;
+}
+
+static void invertScalar(uint64_t* words, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        words[i] = ~words[i];
+    }
+}
+
+#ifdef BITKERNELS_X86
+
+//the wide versions look at 512 bits per step and bail out as soon as a
+//step finds a bit; the remainder goes through the scalar loop
+
+__attribute__((target("avx2")))
+static bool anySetAvx2(const uint64_t* words, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(words + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(words + i + 4));
+        __m256i any = _mm256_or_si256(a, b);
+        if(!_mm256_testz_si256(any, any))
+        {
+            return true;
+        }
+    }
+    return anySetScalar(words + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void invertAvx2(uint64_t* words, size_t count)
+{
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(words + i));
+        _mm256_storeu_si256((__m256i*)(words + i), _mm256_xor_si256(a, ones));
+    }
+    invertScalar(words + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static bool anySetAvx512(const uint64_t* words, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512i a = _mm512_loadu_si512((const void*)(words + i));
+        if(_mm512_test_epi64_mask(a, a) != 0)
+        {
+            return true;
+        }
+    }
+    return anySetScalar(words + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void invertAvx512(uint64_t* words, size_t count)
+{
+    const __m512i ones = _mm512_set1_epi64(-1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512i a = _mm512_loadu_si512((const void*)(words + i));
+        _mm512_storeu_si512((void*)(words + i), _mm512_xor_si512(a, ones));
+    }
+    invertScalar(words + i, count - i);
+}
+
+#endif
+
+static BitKernels pickKernels()
+{
+    BitKernels kernels = {anySetScalar, invertScalar, "scalar"};
+#ifdef BITKERNELS_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+    {
+        kernels.anySet = anySetAvx512;
+        kernels.invert = invertAvx512;
+        kernels.name = "avx512";
+    }
+    else if(__builtin_cpu_supports("avx2"))
+    {
+        kernels.anySet = anySetAvx2;
+        kernels.invert = invertAvx2;
+        kernels.name = "avx2";
+    }
+#endif
+    return kernels;
+}
+
+const BitKernels& bitKernels()
+{
+    static const BitKernels kernels = pickKernels();
+    return kernels;
+}
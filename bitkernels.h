@@ -0,0 +1,24 @@
+#ifndef BITKERNELS_H
+#define BITKERNELS_H
+
+#include <cstddef>
+#include <stdint.h>
+
+/**
+* The two operations the bitboard spends its time in, over a run of
+* contiguous 64-bit words: whether any bit is set, and flipping every bit.
+* There is a scalar version and, on x86, AVX2 and AVX-512 versions; which
+* one runs is decided once, from what the CPU reports through CPUID.
+*/
+struct BitKernels
+{
+    bool (*anySet)(const uint64_t* words, size_t count);
+    void (*invert)(uint64_t* words, size_t count);
+    // "scalar", "avx2" or "avx512", for diagnostics
+    const char* name;
+};
+
+// The fastest kernels this CPU supports
+const BitKernels& bitKernels();
+
+#endif
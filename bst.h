@@ -233,6 +233,7 @@ public:
     iterator begin() const;
     iterator end() const;
     iterator find(const Key& key) const;
+    iterator findBefore(const Key& key) const;
 
 protected:
     // Mandatory helper functions
@@ -437,6 +438,34 @@ BinarySearchTree<Key, Value>::find(const Key & k) const
     return it;
 }
 
+/**
+* Returns an iterator to the item with the largest key
+* strictly less than k, or the end iterator if there is none.
+* k itself does not need to be in the tree.
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::findBefore(const Key & k) const
+{
+    Node<Key, Value> *curr = root_;
+    Node<Key, Value> *best = NULL;
+    while(curr != NULL)
+    {
+        //every key smaller than k is a candidate, so remember it and look right
+        if(curr->getKey() < k)
+        {
+            best = curr;
+            curr = curr->getRight();
+        }
+        else
+        {
+            curr = curr->getLeft();
+        }
+    }
+    BinarySearchTree<Key, Value>::iterator it(best);
+    return it;
+}
+
 /**
 * An insert method to insert into a Binary Search Tree.
 * The tree will not remain balanced when inserting.
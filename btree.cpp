@@ -0,0 +1,252 @@
+#include <climits>
+#include <list>
+#include <utility>
+#include "btree.h"
+#include "anneal.h"
+
+/**
+* Starts from a complete binary tree over the modules in input order
+* (node i has children 2i+1 and 2i+2), all unrotated.
+*/
+BStarTree::BStarTree(const std::vector<Rectangle>& pieces, int outlineWidth, int outlineHeight) :
+    pieces_(pieces), moduleArea_(0), outlineWidth_(outlineWidth), outlineHeight_(outlineHeight)
+{
+    int count = pieces_.size();
+    tree_.left.assign(count, -1);
+    tree_.right.assign(count, -1);
+    tree_.parent.assign(count, -1);
+    tree_.module.resize(count);
+    tree_.rotated.assign(count, 0);
+    tree_.root = count > 0 ? 0 : -1;
+    for (int i = 0; i < count; i++)
+    {
+        tree_.module[i] = i;
+        if(2 * i + 1 < count)
+        {
+            tree_.left[i] = 2 * i + 1;
+            tree_.parent[2 * i + 1] = i;
+        }
+        if(2 * i + 2 < count)
+        {
+            tree_.right[i] = 2 * i + 2;
+            tree_.parent[2 * i + 2] = i;
+        }
+        moduleArea_ += (long long)pieces_[i].length * pieces_[i].height;
+    }
+    x_.resize(count);
+    y_.resize(count);
+    pack();
+    saved_ = tree_;
+    best_ = tree_;
+}
+
+int BStarTree::size() const
+{
+    return pieces_.size();
+}
+
+double BStarTree::cost() const
+{
+    return packingCost(tree_.width, tree_.height, moduleArea_, outlineWidth_, outlineHeight_);
+}
+
+int BStarTree::getWidth() const
+{
+    return tree_.width;
+}
+
+int BStarTree::getHeight() const
+{
+    return tree_.height;
+}
+
+int BStarTree::nodeLength(int node) const
+{
+    const Rectangle& r = pieces_[tree_.module[node]];
+    return tree_.rotated[tree_.module[node]] ? r.height : r.length;
+}
+
+int BStarTree::nodeHeight(int node) const
+{
+    const Rectangle& r = pieces_[tree_.module[node]];
+    return tree_.rotated[tree_.module[node]] ? r.length : r.height;
+}
+
+void BStarTree::perturb(std::mt19937& rng)
+{
+    saved_ = tree_;
+    int count = size();
+    if(count == 0)
+    {
+        return;
+    }
+    int move = count > 1 ? rng() % 3 : 0;
+    if(move == 0)
+    {
+        int module = rng() % count;
+        tree_.rotated[module] = !tree_.rotated[module];
+    }
+    else if(move == 1)
+    {
+        int a = rng() % count;
+        int b = rng() % count;
+        std::swap(tree_.module[a], tree_.module[b]);
+    }
+    else
+    {
+        moveNode(rng);
+    }
+    pack();
+}
+
+/**
+* Takes a random node out of the tree and hangs it under another one. To
+* detach a node with children its module is first swapped down along a
+* random path to a leaf, and the leaf is what moves.
+*/
+void BStarTree::moveNode(std::mt19937& rng)
+{
+    int count = size();
+    int node = rng() % count;
+    while(tree_.left[node] >= 0 || tree_.right[node] >= 0)
+    {
+        int child = tree_.left[node];
+        if(child < 0 || (tree_.right[node] >= 0 && rng() % 2))
+        {
+            child = tree_.right[node];
+        }
+        std::swap(tree_.module[node], tree_.module[child]);
+        node = child;
+    }
+    int parent = tree_.parent[node];
+    if(tree_.left[parent] == node)
+    {
+        tree_.left[parent] = -1;
+    }
+    else
+    {
+        tree_.right[parent] = -1;
+    }
+    int target = rng() % (count - 1);
+    if(target >= node)
+    {
+        target++;
+    }
+    //take over the chosen slot, pushing any child there down one level
+    bool asLeft = rng() % 2;
+    std::vector<int>& slot = asLeft ? tree_.left : tree_.right;
+    int old = slot[target];
+    slot[target] = node;
+    tree_.parent[node] = target;
+    if(asLeft)
+    {
+        tree_.left[node] = old;
+    }
+    else
+    {
+        tree_.right[node] = old;
+    }
+    if(old >= 0)
+    {
+        tree_.parent[old] = node;
+    }
+}
+
+void BStarTree::undo()
+{
+    tree_ = saved_;
+}
+
+void BStarTree::keepBest()
+{
+    best_ = tree_;
+}
+
+void BStarTree::restoreBest()
+{
+    tree_ = best_;
+    pack();
+}
+
+void BStarTree::placements(std::vector<Placement>& placed)
+{
+    pack();
+    placed.clear();
+    for (int node = 0; node < size(); node++)
+    {
+        Placement p = {pieces_[tree_.module[node]].ID, x_[node], y_[node],
+                       nodeLength(node), nodeHeight(node)};
+        placed.push_back(p);
+    }
+}
+
+/**
+* Preorder walk computing every node's coordinates. The contour is a linked
+* list of segments; each node starts its scan at the segment beginning at
+* its own x, which is always at hand: a left child starts where its parent's
+* segment ends, and a right child on its parent's segment, which the left
+* subtree (all further right) cannot have touched. Every placement adds at
+* most two segments and the scan erases the ones it covers, so the whole
+* packing is amortised O(n).
+*/
+void BStarTree::pack()
+{
+    struct Segment
+    {
+        int x;
+        int end;
+        int y;
+    };
+    typedef std::list<Segment>::iterator SegmentIter;
+
+    tree_.width = 0;
+    tree_.height = 0;
+    if(tree_.root < 0)
+    {
+        return;
+    }
+    std::list<Segment> contour;
+    Segment floor = {0, INT_MAX, 0};
+    contour.push_back(floor);
+    std::vector<std::pair<int, SegmentIter> > stack;
+    x_[tree_.root] = 0;
+    stack.push_back(std::make_pair(tree_.root, contour.begin()));
+    while(!stack.empty())
+    {
+        int node = stack.back().first;
+        SegmentIter it = stack.back().second;
+        stack.pop_back();
+        int x = x_[node];
+        int end = x + nodeLength(node);
+        int base = 0;
+        while(it->x < end)
+        {
+            base = std::max(base, it->y);
+            if(it->end <= end)
+            {
+                it = contour.erase(it);
+            }
+            else
+            {
+                it->x = end;
+                break;
+            }
+        }
+        y_[node] = base;
+        Segment top = {x, end, base + nodeHeight(node)};
+        SegmentIter mine = contour.insert(it, top);
+        tree_.width = std::max(tree_.width, end);
+        tree_.height = std::max(tree_.height, top.y);
+        //right child goes on the stack first so the left subtree is packed before it
+        if(tree_.right[node] >= 0)
+        {
+            x_[tree_.right[node]] = x;
+            stack.push_back(std::make_pair(tree_.right[node], mine));
+        }
+        if(tree_.left[node] >= 0)
+        {
+            x_[tree_.left[node]] = end;
+            stack.push_back(std::make_pair(tree_.left[node], it));
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <vector>
+#include <random>
+#include "floorplan.h"
+
+/**
+* A B*-tree floorplan. Every node holds one module; the left child of a node
+* is placed immediately to its right (x = parent.x + parent.length) and the
+* right child directly above it (x = parent.x), each dropped onto the
+* current contour. Packing is a preorder walk in O(n).
+*
+* The tree is kept in index arrays rather than as Node objects from bst.h so
+* that a whole configuration can be saved and restored by copying vectors,
+* which the annealing moves need. The perturbations are rotating a module,
+* swapping the modules of two nodes, and moving a node elsewhere in the tree.
+* It satisfies the Plan interface of anneal().
+*/
+class BStarTree
+{
+public:
+    // An outline of 0 x 0 means minimise area with no fixed outline
+    BStarTree(const std::vector<Rectangle>& pieces, int outlineWidth, int outlineHeight);
+
+    int size() const;
+    double cost() const;
+    void perturb(std::mt19937& rng);
+    void undo();
+    void keepBest();
+    void restoreBest();
+
+    // Bounding box of the current packing
+    int getWidth() const;
+    int getHeight() const;
+
+    // Coordinates of every module in the current packing
+    void placements(std::vector<Placement>& placed);
+
+private:
+    struct TreeState
+    {
+        std::vector<int> left;
+        std::vector<int> right;
+        std::vector<int> parent;
+        // module held by each node
+        std::vector<int> module;
+        // whether each module is turned by 90 degrees
+        std::vector<char> rotated;
+        int root;
+        int width;
+        int height;
+    };
+
+    void pack();
+    void moveNode(std::mt19937& rng);
+    int nodeLength(int node) const;
+    int nodeHeight(int node) const;
+
+    std::vector<Rectangle> pieces_;
+    TreeState tree_;
+    TreeState saved_;
+    TreeState best_;
+    std::vector<int> x_;
+    std::vector<int> y_;
+    long long moduleArea_;
+    int outlineWidth_;
+    int outlineHeight_;
+};
+
+#endif
@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "cache.h"
+#include "binformat.h"
+#include "mappedfile.h"
+
+using namespace std;
+
+const char CACHE_MAGIC[4] = {'F', 'P', 'C', 'A'};
+const uint32_t CACHE_FORMAT_VERSION = 1;
+
+// Header of a cache file, followed by the key, the placements and the
+// reason
+struct CacheFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t keyLength;
+    uint32_t flags;
+    int32_t width;
+    int32_t height;
+    uint32_t count;
+    uint32_t reasonLength;
+};
+
+// A piece in the canonical order
+struct CanonicalPiece
+{
+    int shortSide;
+    int longSide;
+    int index;
+};
+
+bool canonicalLess(const CanonicalPiece& a, const CanonicalPiece& b)
+{
+    if(a.shortSide != b.shortSide)
+    {
+        return a.shortSide < b.shortSide;
+    }
+    if(a.longSide != b.longSide)
+    {
+        return a.longSide < b.longSide;
+    }
+    return a.index < b.index;
+}
+
+void appendInt(string& s, int32_t value)
+{
+    s.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// 64-bit hash of a key, folded eight bytes at a time through the splitmix64
+// finaliser
+uint64_t cacheHash(const string& key)
+{
+    uint64_t h = key.size();
+    for (size_t i = 0; i < key.size(); i += 8)
+    {
+        uint64_t word = 0;
+        memcpy(&word, key.data() + i, std::min<size_t>(8, key.size() - i));
+        h ^= word;
+        h += 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+ResultCache::ResultCache(const SolverOptions& opts, const std::string& directory) :
+    directory_(directory)
+{
+    ostringstream os;
+    os << "time=" << opts.timeLimitMs << ";nodes=" << opts.nodeLimit << ";strip=" << opts.strip
+       << ";minarea=" << opts.minArea << ";heuristic=" << opts.heuristic << ";lns=" << opts.lnsIterations
+       << ";engine=" << opts.engine << ";restarts=" << opts.restarts << ";seed=" << opts.seed
+       << ";portfolio=" << opts.portfolio << ";";
+    options_ = os.str();
+}
+
+std::string ResultCache::key(const Instance& instance, std::vector<int>& ranks) const
+{
+    vector<CanonicalPiece> order(instance.pieces.size());
+    for (size_t i = 0; i < instance.pieces.size(); i++)
+    {
+        const Rectangle& r = instance.pieces[i];
+        CanonicalPiece piece = {std::min(r.length, r.height), std::max(r.length, r.height), (int)i};
+        order[i] = piece;
+    }
+    sort(order.begin(), order.end(), canonicalLess);
+    string k = options_;
+    k.reserve(k.size() + 12 + 8 * order.size());
+    appendInt(k, instance.width);
+    appendInt(k, instance.height);
+    appendInt(k, order.size());
+    ranks.resize(order.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        appendInt(k, order[i].shortSide);
+        appendInt(k, order[i].longSide);
+        ranks[order[i].index] = i;
+    }
+    return k;
+}
+
+std::string ResultCache::path(const std::string& key) const
+{
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)cacheHash(key));
+    //fan the files out over 256 directories
+    return directory_ + "/" + string(name, 2) + "/" + string(name + 2);
+}
+
+bool ResultCache::load(const std::string& key, CachedAnswer& answer) const
+{
+    MappedFile file;
+    if(!file.open(path(key)))
+    {
+        return false;
+    }
+    const char* p = file.data();
+    size_t size = file.size();
+    CacheFileHeader header;
+    if(size < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, p, sizeof(header));
+    if(memcmp(header.magic, CACHE_MAGIC, 4) != 0 || header.version != CACHE_FORMAT_VERSION ||
+       header.keyLength != key.size() ||
+       size != sizeof(header) + key.size() + header.count * sizeof(CachedPlacement) + header.reasonLength ||
+       memcmp(p + sizeof(header), key.data(), key.size()) != 0)
+    {
+        return false;
+    }
+    p += sizeof(header) + key.size();
+    answer.flags = header.flags;
+    answer.width = header.width;
+    answer.height = header.height;
+    answer.placements.resize(header.count);
+    if(header.count > 0)
+    {
+        memcpy(&answer.placements[0], p, header.count * sizeof(CachedPlacement));
+    }
+    p += header.count * sizeof(CachedPlacement);
+    answer.reason.assign(p, header.reasonLength);
+    return true;
+}
+
+void ResultCache::save(const std::string& key, const CachedAnswer& answer) const
+{
+    string target = path(key);
+    mkdir(directory_.c_str(), 0777);
+    mkdir(target.substr(0, target.find_last_of('/')).c_str(), 0777);
+    //written under a private name and renamed into place, so a reader
+    //never sees half a file
+    ostringstream temp;
+    temp << target << ".tmp." << getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+    {
+        ofstream ofile(temp.str().c_str(), ios::binary);
+        CacheFileHeader header;
+        memcpy(header.magic, CACHE_MAGIC, 4);
+        header.version = CACHE_FORMAT_VERSION;
+        header.keyLength = key.size();
+        header.flags = answer.flags;
+        header.width = answer.width;
+        header.height = answer.height;
+        header.count = answer.placements.size();
+        header.reasonLength = answer.reason.size();
+        ofile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofile.write(key.data(), key.size());
+        if(!answer.placements.empty())
+        {
+            ofile.write(reinterpret_cast<const char*>(&answer.placements[0]),
+                        answer.placements.size() * sizeof(CachedPlacement));
+        }
+        ofile.write(answer.reason.data(), answer.reason.size());
+        if(!ofile)
+        {
+            ofile.close();
+            unlink(temp.str().c_str());
+            return;
+        }
+    }
+    if(rename(temp.str().c_str(), target.c_str()) != 0)
+    {
+        unlink(temp.str().c_str());
+    }
+}
+
+void ResultCache::remember(const std::string& key, const CachedAnswer& answer)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    if(index_.count(key) > 0)
+    {
+        return;
+    }
+    entries_.push_front(std::make_pair(key, answer));
+    index_[key] = entries_.begin();
+    if(entries_.size() > RESULT_CACHE_LIMIT)
+    {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+}
+
+bool ResultCache::find(const Instance& instance, SolveResult& result)
+{
+    vector<int> ranks;
+    string k = key(instance, ranks);
+    CachedAnswer answer;
+    bool hit = false;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        unordered_map<string, EntryList::iterator>::iterator it = index_.find(k);
+        if(it != index_.end())
+        {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            answer = it->second->second;
+            hit = true;
+        }
+    }
+    if(!hit && !directory_.empty() && load(k, answer))
+    {
+        remember(k, answer);
+        hit = true;
+    }
+    if(!hit)
+    {
+        return false;
+    }
+
+    //map ranks back to the pieces of this instance
+    vector<int> byRank(ranks.size());
+    for (size_t i = 0; i < ranks.size(); i++)
+    {
+        byRank[ranks[i]] = i;
+    }
+    result = SolveResult();
+    result.complete = (answer.flags & SOLUTION_COMPLETE) != 0;
+    result.exhausted = (answer.flags & SOLUTION_EXHAUSTED) != 0;
+    result.optimal = (answer.flags & SOLUTION_OPTIMAL) != 0;
+    result.width = answer.width;
+    result.height = answer.height;
+    for (size_t i = 0; i < answer.placements.size(); i++)
+    {
+        const CachedPlacement& c = answer.placements[i];
+        if(c.rank < 0 || c.rank >= (int)byRank.size())
+        {
+            return false;
+        }
+        const Rectangle& r = instance.pieces[byRank[c.rank]];
+        int shortSide = std::min(r.length, r.height);
+        int longSide = std::max(r.length, r.height);
+        Placement p = {r.ID, c.x, c.y, c.rotated ? longSide : shortSide, c.rotated ? shortSide : longSide};
+        result.placements.push_back(p);
+    }
+    //"{rank}" stands for a piece ID, "{rank:shape}" for an ID and its sides
+    ostringstream reason;
+    for (size_t i = 0; i < answer.reason.size(); i++)
+    {
+        size_t close = answer.reason.find('}', i);
+        if(answer.reason[i] != '{' || close == string::npos)
+        {
+            reason << answer.reason[i];
+            continue;
+        }
+        string token = answer.reason.substr(i + 1, close - i - 1);
+        size_t rank = atoi(token.c_str());
+        if(rank < byRank.size())
+        {
+            const Rectangle& r = instance.pieces[byRank[rank]];
+            reason << r.ID;
+            if(token.find(":shape") != string::npos)
+            {
+                reason << " (" << r.length << " x " << r.height << ")";
+            }
+        }
+        i = close;
+    }
+    result.reason = reason.str();
+    return true;
+}
+
+void ResultCache::store(const Instance& instance, const SolveResult& result)
+{
+    if(result.exhausted)
+    {
+        return;
+    }
+    vector<int> ranks;
+    string k = key(instance, ranks);
+    unordered_map<int, int> indexOf;
+    for (size_t i = 0; i < instance.pieces.size(); i++)
+    {
+        indexOf[instance.pieces[i].ID] = i;
+    }
+    CachedAnswer answer;
+    answer.flags = (result.complete ? SOLUTION_COMPLETE : 0) | (result.optimal ? SOLUTION_OPTIMAL : 0);
+    answer.width = result.width;
+    answer.height = result.height;
+    for (size_t i = 0; i < result.placements.size(); i++)
+    {
+        const Placement& p = result.placements[i];
+        unordered_map<int, int>::iterator it = indexOf.find(p.ID);
+        if(it == indexOf.end())
+        {
+            return;
+        }
+        CachedPlacement c = {ranks[it->second], p.x, p.y, p.length > p.height};
+        answer.placements.push_back(c);
+    }
+    //name pieces in the reason by rank, since another instance with the
+    //same canonical form will know them by other IDs
+    const string& text = result.reason;
+    size_t i = 0;
+    while(i < text.size())
+    {
+        size_t found = text.find("piece ", i);
+        if(found == string::npos)
+        {
+            answer.reason += text.substr(i);
+            break;
+        }
+        size_t digits = found + 6;
+        answer.reason += text.substr(i, digits - i);
+        i = digits;
+        size_t end = digits < text.size() && text[digits] == '-' ? digits + 1 : digits;
+        size_t first = end;
+        while(end < text.size() && isdigit(text[end]))
+        {
+            end++;
+        }
+        unordered_map<int, int>::iterator it = end > first ? indexOf.find(atoi(text.c_str() + digits)) : indexOf.end();
+        if(it == indexOf.end())
+        {
+            continue;
+        }
+        ostringstream token;
+        token << "{" << ranks[it->second];
+        //the sides that follow are given again from the other instance
+        size_t shape = text.find(')', end);
+        if(text.compare(end, 2, " (") == 0 && shape != string::npos)
+        {
+            token << ":shape";
+            end = shape + 1;
+        }
+        token << "}";
+        answer.reason += token.str();
+        i = end;
+    }
+    if(!directory_.empty())
+    {
+        save(k, answer);
+    }
+    remember(k, answer);
+}
+
+SolveResult solveCached(const Instance& instance, const SolverOptions& opts, ResultCache* cache)
+{
+    SolveResult result;
+    if(cache != NULL && cache->find(instance, result))
+    {
+        return result;
+    }
+    FloorplanSolver solver(instance.width, instance.height, instance.pieces, opts);
+    result = solver.solve();
+    if(cache != NULL)
+    {
+        cache->store(instance, result);
+    }
+    return result;
+}
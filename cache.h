@@ -0,0 +1,91 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include "instance.h"
+#include "solver.h"
+
+// Answers a ResultCache holds in memory before it drops the least recently
+// used
+const size_t RESULT_CACHE_LIMIT = 1 << 16;
+
+/**
+* Answers to instances already solved, for a process that solves many
+* with the same options, addressed by content rather than by piece IDs.
+*
+* An instance is reduced to a canonical form: the board, then the piece
+* shapes as (short side, long side) pairs in sorted order. Two instances
+* that only differ in their IDs, in the order the pieces are listed or in
+* which way round each is given have the same canonical form, and so share
+* an answer. Answers are stored against the rank of each piece in that
+* order (and whether it is turned from short side by long side), and on a
+* hit are mapped back to the IDs and orientations of the instance asked
+* about; pieces named in an infeasibility reason are renamed the same way.
+*
+* Entries are kept in memory and, if a directory is given, also on disk
+* as one file per canonical form, named by a 64-bit hash of it (plus the
+* options) and holding the full form to rule out collisions, so other
+* processes and later runs share them. Only settled answers are kept: an
+* answer found when the budget ran out could come out better on another
+* try. Safe to share between threads.
+*/
+class ResultCache
+{
+public:
+    explicit ResultCache(const SolverOptions& opts, const std::string& directory = "");
+
+    // Looks instance up, filling result on a hit
+    bool find(const Instance& instance, SolveResult& result);
+    void store(const Instance& instance, const SolveResult& result);
+
+private:
+    // Where a piece went, by its rank in the canonical order
+    struct CachedPlacement
+    {
+        int32_t rank;
+        int32_t x;
+        int32_t y;
+        // 1 if placed long side by short side
+        int32_t rotated;
+    };
+
+    // An answer in canonical terms
+    struct CachedAnswer
+    {
+        uint32_t flags;
+        int32_t width;
+        int32_t height;
+        std::vector<CachedPlacement> placements;
+        // the reason with every "piece <ID>" replaced by a rank placeholder
+        std::string reason;
+    };
+
+    typedef std::list<std::pair<std::string, CachedAnswer> > EntryList;
+
+    // The canonical form of instance, with options_ in front, and the rank
+    // of each of its pieces, in the order of instance.pieces
+    std::string key(const Instance& instance, std::vector<int>& ranks) const;
+    std::string path(const std::string& key) const;
+    bool load(const std::string& key, CachedAnswer& answer) const;
+    void save(const std::string& key, const CachedAnswer& answer) const;
+    void remember(const std::string& key, const CachedAnswer& answer);
+
+    // the options, written out, as the first part of every key
+    std::string options_;
+    std::string directory_;
+    std::mutex lock_;
+    // most recently used first
+    EntryList entries_;
+    std::unordered_map<std::string, EntryList::iterator> index_;
+};
+
+// Solves instance, or answers it from cache if cache is not NULL and holds
+// it (storing the answer there otherwise)
+SolveResult solveCached(const Instance& instance, const SolverOptions& opts, ResultCache* cache);
+
+#endif
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include "contour.h"
+
+Contour::Contour(int width) : width_(width)
+{
+    head_ = new Segment();
+    head_->x = 0;
+    head_->end = width;
+    head_->y = 0;
+    head_->prev = NULL;
+    head_->next = NULL;
+    index_.insert(std::make_pair(0, head_));
+}
+
+Contour::~Contour()
+{
+    while(head_ != NULL)
+    {
+        Segment* next = head_->next;
+        delete head_;
+        head_ = next;
+    }
+}
+
+const Contour::Segment* Contour::first() const
+{
+    return head_;
+}
+
+const Contour::Segment* Contour::locate(int x) const
+{
+    return find(x);
+}
+
+int Contour::getWidth() const
+{
+    return width_;
+}
+
+Contour::Segment* Contour::find(int x) const
+{
+    if(x < 0 || x >= width_)
+    {
+        return NULL;
+    }
+    //the segment covering x is the one starting at or just before it
+    AVLTree<int, Segment*>::iterator it = index_.findBefore(x + 1);
+    return it == index_.end() ? NULL : it->second;
+}
+
+int Contour::maxHeight(int x1, int x2) const
+{
+    int y = 0;
+    for (const Segment* s = find(x1); s != NULL && s->x < x2; s = s->next)
+    {
+        y = std::max(y, s->y);
+    }
+    return y;
+}
+
+// Makes sure a segment starts exactly at x and returns it
+Contour::Segment* Contour::splitAt(int x)
+{
+    Segment* s = find(x);
+    if(s->x == x)
+    {
+        return s;
+    }
+    Segment* t = new Segment();
+    t->x = x;
+    t->end = s->end;
+    t->y = s->y;
+    t->prev = s;
+    t->next = s->next;
+    if(s->next != NULL)
+    {
+        s->next->prev = t;
+    }
+    s->next = t;
+    s->end = x;
+    index_.insert(std::make_pair(x, t));
+    return t;
+}
+
+// Takes a segment out of the list and the index and frees it
+void Contour::unlink(Segment* s)
+{
+    if(s->prev != NULL)
+    {
+        s->prev->next = s->next;
+    }
+    else
+    {
+        head_ = s->next;
+    }
+    if(s->next != NULL)
+    {
+        s->next->prev = s->prev;
+    }
+    index_.remove(s->x);
+    delete s;
+}
+
+void Contour::raise(int x1, int x2, int y)
+{
+    if(x1 >= x2)
+    {
+        return;
+    }
+    Segment* s = splitAt(x1);
+    if(x2 < width_)
+    {
+        splitAt(x2);
+    }
+    //s absorbs every segment up to x2
+    while(s->next != NULL && s->next->x < x2)
+    {
+        unlink(s->next);
+    }
+    s->end = x2;
+    s->y = y;
+    if(s->next != NULL && s->next->y == y)
+    {
+        s->end = s->next->end;
+        unlink(s->next);
+    }
+    if(s->prev != NULL && s->prev->y == y)
+    {
+        s->prev->end = s->end;
+        unlink(s);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef CONTOUR_H
+#define CONTOUR_H
+
+#include "avlbst.h"
+
+/**
+* The contour (skyline) of a packing over [0, width): the top edge of the
+* placed pieces as a doubly-linked list of horizontal segments, with an
+* AVLTree over the segments' left ends so the segment under any x is found
+* in O(log n). Raising an interval splits at most two segments and erases
+* the ones it covers, so updates are O(log n) amortised per segment
+* touched, and a max-over-interval query is O(log n + k) for k segments.
+*/
+class Contour
+{
+public:
+    struct Segment
+    {
+        int x;
+        int end;
+        int y;
+        Segment* prev;
+        Segment* next;
+    };
+
+    Contour(int width);
+    ~Contour();
+
+    // Leftmost segment; follow next to walk the whole contour
+    const Segment* first() const;
+
+    // Segment covering x, or NULL if x is outside [0, width)
+    const Segment* locate(int x) const;
+
+    // Highest point of the contour over [x1, x2)
+    int maxHeight(int x1, int x2) const;
+
+    // Sets the contour over [x1, x2) to y, merging equal neighbours
+    void raise(int x1, int x2, int y);
+
+    int getWidth() const;
+
+private:
+    Contour(const Contour&);
+    Contour& operator=(const Contour&);
+
+    Segment* find(int x) const;
+    Segment* splitAt(int x);
+    void unlink(Segment* s);
+
+    AVLTree<int, Segment*> index_;
+    Segment* head_;
+    int width_;
+};
+
+#endif
@@ -0,0 +1,222 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "daemon.h"
+#include "stream.h"
+#include "cache.h"
+
+using namespace std;
+
+// Fills addr for the socket at path. Returns false if the path is too long
+// for a socket address.
+bool socketAddress(const std::string& path, struct sockaddr_un& addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path))
+    {
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Body of one connection thread; source names the connection in errors
+void serveConnection(int fd, std::string source, const SolverOptions& opts, int threads, ResultCache& cache)
+{
+    FdStreamBuf buffer(fd);
+    std::ostream out(&buffer);
+    //runStream() reports errors after all the answers, so the marked line
+    //is always the last one
+    ostringstream errors;
+    if(!runStream(fd, source, out, opts, threads, errors, &cache))
+    {
+        out << DAEMON_ERROR_PREFIX << errors.str();
+    }
+    out.flush();
+    close(fd);
+}
+
+bool runDaemon(const std::string& path, const SolverOptions& opts, int threads, const std::string& cacheDir,
+               std::ostream& log)
+{
+    struct sockaddr_un addr;
+    if(!socketAddress(path, addr))
+    {
+        log << "socket path too long: " << path << endl;
+        return false;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0)
+    {
+        log << "cannot create a socket: " << strerror(errno) << endl;
+        return false;
+    }
+    unlink(path.c_str());
+    if(bind(listener, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+       listen(listener, SOMAXCONN) != 0)
+    {
+        log << "cannot listen on " << path << ": " << strerror(errno) << endl;
+        close(listener);
+        return false;
+    }
+    //a client that hangs up early must not take the daemon down with it
+    signal(SIGPIPE, SIG_IGN);
+    if(threads <= 0)
+    {
+        threads = 1;
+    }
+    log << "listening on " << path << endl;
+
+    //lives as long as the process, which never leaves the loop below
+    ResultCache cache(opts, cacheDir);
+    for (unsigned long connection = 1; ; connection++)
+    {
+        int fd = accept(listener, NULL, NULL);
+        if(fd < 0)
+        {
+            if(errno != EINTR && errno != ECONNABORTED)
+            {
+                log << "accept failed: " << strerror(errno) << endl;
+            }
+            continue;
+        }
+        ostringstream source;
+        source << "connection " << connection;
+        try
+        {
+            std::thread(serveConnection, fd, source.str(), std::cref(opts), threads, std::ref(cache)).detach();
+        }
+        catch(const std::system_error& e)
+        {
+            //out of threads: turn this client away, keep serving the rest
+            log << "cannot serve " << source.str() << ": " << e.what() << endl;
+            close(fd);
+        }
+    }
+}
+
+// Copies everything on from to the socket, counting the bytes in sent,
+// then tells the daemon the input is over
+void sendAll(int from, int socket, size_t& sent)
+{
+    vector<char> buffer(1 << 16);
+    for (;;)
+    {
+        ssize_t got = read(from, &buffer[0], buffer.size());
+        if(got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(got <= 0)
+        {
+            break;
+        }
+        for (ssize_t done = 0; done < got; )
+        {
+            ssize_t put = write(socket, &buffer[done], got - done);
+            if(put < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(put <= 0)
+            {
+                shutdown(socket, SHUT_WR);
+                return;
+            }
+            done += put;
+            sent += put;
+        }
+    }
+    shutdown(socket, SHUT_WR);
+}
+
+// Bytes of the daemon's reply the client keeps to look for an error line
+const size_t CLIENT_TAIL_SIZE = 4096;
+
+// Checks whether the last line of reply is the daemon's error line
+bool endsWithError(const std::string& reply)
+{
+    size_t last = reply.size();
+    if(last > 0 && reply[last - 1] == '\n')
+    {
+        last--;
+    }
+    size_t begin = reply.rfind('\n', last == 0 ? 0 : last - 1);
+    begin = begin == string::npos ? 0 : begin + 1;
+    return reply.compare(begin, strlen(DAEMON_ERROR_PREFIX), DAEMON_ERROR_PREFIX) == 0;
+}
+
+bool runClient(const std::string& path, int in, int out, std::ostream& errors)
+{
+    struct sockaddr_un addr;
+    if(!socketAddress(path, addr))
+    {
+        errors << "socket path too long: " << path << endl;
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        errors << "cannot reach the daemon at " << path << ": " << strerror(errno) << endl;
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    //the input goes out on its own thread so answers are passed on while
+    //the rest is still being sent
+    size_t sent = 0;
+    std::thread sender(sendAll, in, fd, std::ref(sent));
+    FdStreamBuf buffer(out);
+    vector<char> chunk(1 << 16);
+    size_t received = 0;
+    int readError = 0;
+    //the end of what came back, enough to hold the error line if any
+    string tail;
+    for (;;)
+    {
+        ssize_t got = read(fd, &chunk[0], chunk.size());
+        if(got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(got <= 0)
+        {
+            readError = got < 0 ? errno : 0;
+            break;
+        }
+        buffer.sputn(&chunk[0], got);
+        buffer.pubsync();
+        received += got;
+        tail.append(&chunk[0], got);
+        if(tail.size() > CLIENT_TAIL_SIZE)
+        {
+            tail.erase(0, tail.size() - CLIENT_TAIL_SIZE);
+        }
+    }
+    sender.join();
+    close(fd);
+    if(readError != 0)
+    {
+        errors << "lost the daemon at " << path << ": " << strerror(readError) << endl;
+        return false;
+    }
+    //the daemon answers every input, if only with an error, so silence
+    //means it went away
+    if(received == 0 && sent > 0)
+    {
+        errors << "the daemon at " << path << " closed the connection without answering" << endl;
+        return false;
+    }
+    return !endsWithError(tail);
+}
@@ -0,0 +1,37 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <iostream>
+#include <string>
+#include "solver.h"
+
+// Starts the line a daemon sends after the answers when a connection's
+// input was malformed
+const char DAEMON_ERROR_PREFIX[] = "Error: ";
+
+/**
+* Serves instances on the Unix domain socket at path until the process is
+* killed, replacing any stale socket file there. Every connection is a
+* stream as in runStream(): the client writes instances, text or binary,
+* and reads back the answers in order, followed by a line starting with
+* DAEMON_ERROR_PREFIX if its input was malformed, which names the
+* connection as "connection k".
+* Connections are served at once on threads of their own, each solving
+* with threads threads, and all of them share one ResultCache, so an
+* instance any client has had answered before (or, with a cache
+* directory, any run using it) costs no search. Returns false, after
+* saying why on log, if the socket cannot be set up.
+*/
+bool runDaemon(const std::string& path, const SolverOptions& opts, int threads, const std::string& cacheDir,
+               std::ostream& log);
+
+/**
+* Sends everything on the file descriptor in to the daemon at path and
+* copies its answers to the file descriptor out as they arrive. Returns
+* false if the daemon reports the input malformed, or, after saying why on
+* errors, if it cannot be reached or drops the connection without
+* answering.
+*/
+bool runClient(const std::string& path, int in, int out, std::ostream& errors);
+
+#endif
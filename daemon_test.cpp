@@ -0,0 +1,75 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "daemon.h"
+
+using namespace std;
+
+int failures = 0;
+
+// Sends text through a client to the daemon at path and checks whether
+// runClient() reports success as expected
+void expect(const string& path, const string& text, bool expected)
+{
+    char name[] = "/tmp/daemon_test.XXXXXX";
+    int in = mkstemp(name);
+    unlink(name);
+    if(in < 0 || write(in, text.data(), text.size()) != (ssize_t)text.size())
+    {
+        cout << "FAIL: cannot write the client's input" << endl;
+        failures++;
+        return;
+    }
+    lseek(in, 0, SEEK_SET);
+    int out = open("/dev/null", O_WRONLY);
+    ostringstream errors;
+    bool ok = runClient(path, in, out, errors);
+    close(in);
+    close(out);
+    if(ok != expected)
+    {
+        cout << "FAIL: \"" << text << "\" gave " << (ok ? "success" : "failure") << " " << errors.str() << endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    ostringstream path;
+    path << "/tmp/daemon_test." << getpid() << ".sock";
+    pid_t daemon = fork();
+    if(daemon == 0)
+    {
+        ostringstream log;
+        runDaemon(path.str(), SolverOptions(), 1, "", log);
+        _exit(1);
+    }
+    struct stat info;
+    for (int i = 0; i < 500 && stat(path.str().c_str(), &info) != 0; i++)
+    {
+        usleep(10000);
+    }
+
+    expect(path.str(), "4 3 1\n1 2 2\n", true);
+    expect(path.str(), "4 3 1\n1 2 x\n", false);
+    expect(path.str(), "4 3 1\n1 2 2\n4 3 1\n1 2 x\n", false);
+    //a bad request must not take the daemon down for the next client
+    expect(path.str(), "4 3 2\n1 2 2\n2 2 1\n", true);
+
+    kill(daemon, SIGTERM);
+    waitpid(daemon, NULL, 0);
+    unlink(path.str().c_str());
+    if(failures > 0)
+    {
+        return 1;
+    }
+    cout << "daemon tests passed" << endl;
+    return 0;
+}
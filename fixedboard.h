@@ -0,0 +1,282 @@
+#ifndef FIXEDBOARD_H
+#define FIXEDBOARD_H
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+/**
+* A board of at most 64 * Words cells held in a fixed array of Words
+* 64-bit words, cell (x, y) being bit x * height + y. Since Words is known
+* at compile time every operation is a fixed, fully unrolled sequence of
+* word operations with no loops over the board left at run time, and the
+* whole board fits in a few registers.
+*
+* A piece shape is prepared once as a mask of the whole shape at (0, 0);
+* placing it at (x, y) shifts that mask by x * height + y bits, so checking
+* is Words ANDs and placing or lifting is Words XORs. Pieces with the same
+* shape share a mask. Free regions are found the same way, by growing a
+* mask with shifts instead of visiting cells one by one.
+*/
+template <int Words>
+class FixedBoard
+{
+public:
+    FixedBoard(int width, int height);
+
+    // Builds the mask for length x height pieces, if not done yet
+    void prepare(int length, int height);
+
+    // Rectangle query and toggle over [x, x+length) x [y, y+height). The
+    // rectangle must lie on the board and its shape must have been prepared.
+    bool isEmpty(int x, int y, int length, int height) const;
+    void flip(int x, int y, int length, int height);
+
+    // Single cell access
+    bool get(int x, int y) const;
+    void toggle(int x, int y);
+
+    int getWidth() const;
+    int getHeight() const;
+
+    // The free cells as a mask
+    void freeCells(uint64_t* out) const;
+
+    // The 4-connected region, within the cells set in free, of the lowest
+    // cell set in free (which must not be empty)
+    void regionOf(const uint64_t* free, uint64_t* region) const;
+
+private:
+    struct Mask
+    {
+        uint64_t word[Words];
+    };
+
+    // The mask of a shape moved up by shift bits
+    void shifted(const Mask& mask, int shift, uint64_t* out) const;
+
+    // A mask moved up (to higher cells) or down by shift bits
+    static void shiftUp(const uint64_t* in, int shift, uint64_t* out);
+    static void shiftDown(const uint64_t* in, int shift, uint64_t* out);
+
+    int width_;
+    int height_;
+    uint64_t bits_[Words];
+    // every cell of the board, and the cells with y above 0 and below
+    // height - 1, which keep the regions from wrapping around columns
+    uint64_t board_[Words];
+    uint64_t notBottom_[Words];
+    uint64_t notTop_[Words];
+    // masks_[length * (height_ + 1) + height], with prepared_ saying which
+    // entries have been built
+    std::vector<Mask> masks_;
+    std::vector<bool> prepared_;
+};
+
+template <int Words>
+FixedBoard<Words>::FixedBoard(int width, int height) :
+    width_(width), height_(height),
+    masks_((size_t)(width + 1) * (height + 1)), prepared_((size_t)(width + 1) * (height + 1), false)
+{
+    for (int k = 0; k < Words; k++)
+    {
+        bits_[k] = 0;
+        board_[k] = 0;
+        notBottom_[k] = 0;
+        notTop_[k] = 0;
+    }
+    for (int x = 0; x < width; x++)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            int bit = x * height + y;
+            uint64_t one = (uint64_t)1 << (bit & 63);
+            board_[bit >> 6] |= one;
+            if(y > 0)
+            {
+                notBottom_[bit >> 6] |= one;
+            }
+            if(y < height - 1)
+            {
+                notTop_[bit >> 6] |= one;
+            }
+        }
+    }
+}
+
+template <int Words>
+void FixedBoard<Words>::prepare(int length, int height)
+{
+    if(length > width_ || height > height_)
+    {
+        return;
+    }
+    size_t index = (size_t)length * (height_ + 1) + height;
+    if(prepared_[index])
+    {
+        return;
+    }
+    Mask& mask = masks_[index];
+    for (int k = 0; k < Words; k++)
+    {
+        mask.word[k] = 0;
+    }
+    for (int x = 0; x < length; x++)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            int bit = x * height_ + y;
+            mask.word[bit >> 6] |= (uint64_t)1 << (bit & 63);
+        }
+    }
+    prepared_[index] = true;
+}
+
+template <int Words>
+inline void FixedBoard<Words>::shiftUp(const uint64_t* in, int shift, uint64_t* out)
+{
+    int words = shift >> 6;
+    int bits = shift & 63;
+    for (int k = Words - 1; k >= 0; k--)
+    {
+        uint64_t word = 0;
+        if(k - words >= 0)
+        {
+            word = in[k - words] << bits;
+            if(bits != 0 && k - words - 1 >= 0)
+            {
+                word |= in[k - words - 1] >> (64 - bits);
+            }
+        }
+        out[k] = word;
+    }
+}
+
+template <int Words>
+inline void FixedBoard<Words>::shiftDown(const uint64_t* in, int shift, uint64_t* out)
+{
+    int words = shift >> 6;
+    int bits = shift & 63;
+    for (int k = 0; k < Words; k++)
+    {
+        uint64_t word = 0;
+        if(k + words < Words)
+        {
+            word = in[k + words] >> bits;
+            if(bits != 0 && k + words + 1 < Words)
+            {
+                word |= in[k + words + 1] << (64 - bits);
+            }
+        }
+        out[k] = word;
+    }
+}
+
+template <int Words>
+inline void FixedBoard<Words>::shifted(const Mask& mask, int shift, uint64_t* out) const
+{
+    shiftUp(mask.word, shift, out);
+}
+
+template <int Words>
+inline bool FixedBoard<Words>::isEmpty(int x, int y, int length, int height) const
+{
+    uint64_t piece[Words];
+    shifted(masks_[(size_t)length * (height_ + 1) + height], x * height_ + y, piece);
+    uint64_t overlap = 0;
+    for (int k = 0; k < Words; k++)
+    {
+        overlap |= bits_[k] & piece[k];
+    }
+    return overlap == 0;
+}
+
+template <int Words>
+inline void FixedBoard<Words>::flip(int x, int y, int length, int height)
+{
+    uint64_t piece[Words];
+    shifted(masks_[(size_t)length * (height_ + 1) + height], x * height_ + y, piece);
+    for (int k = 0; k < Words; k++)
+    {
+        bits_[k] ^= piece[k];
+    }
+}
+
+template <int Words>
+inline bool FixedBoard<Words>::get(int x, int y) const
+{
+    int bit = x * height_ + y;
+    return (bits_[bit >> 6] >> (bit & 63)) & 1;
+}
+
+template <int Words>
+inline void FixedBoard<Words>::toggle(int x, int y)
+{
+    int bit = x * height_ + y;
+    bits_[bit >> 6] ^= (uint64_t)1 << (bit & 63);
+}
+
+template <int Words>
+void FixedBoard<Words>::freeCells(uint64_t* out) const
+{
+    for (int k = 0; k < Words; k++)
+    {
+        out[k] = board_[k] & ~bits_[k];
+    }
+}
+
+/**
+* Floods out from the seed a step in every direction at a time: one bit up
+* or down within a column (masked so it cannot cross into the next column)
+* and height bits to the neighbouring columns, until nothing changes.
+*/
+template <int Words>
+void FixedBoard<Words>::regionOf(const uint64_t* free, uint64_t* region) const
+{
+    for (int k = 0; k < Words; k++)
+    {
+        region[k] = 0;
+    }
+    for (int k = 0; k < Words; k++)
+    {
+        if(free[k] != 0)
+        {
+            region[k] = free[k] & (~free[k] + 1);
+            break;
+        }
+    }
+    bool grown = true;
+    while(grown)
+    {
+        uint64_t up[Words];
+        uint64_t down[Words];
+        uint64_t right[Words];
+        uint64_t left[Words];
+        shiftUp(region, 1, up);
+        shiftDown(region, 1, down);
+        shiftUp(region, height_, right);
+        shiftDown(region, height_, left);
+        grown = false;
+        for (int k = 0; k < Words; k++)
+        {
+            uint64_t next = (region[k] | (up[k] & notBottom_[k]) | (down[k] & notTop_[k]) |
+                             right[k] | left[k]) & free[k];
+            grown = grown || next != region[k];
+            region[k] = next;
+        }
+    }
+}
+
+template <int Words>
+int FixedBoard<Words>::getWidth() const
+{
+    return width_;
+}
+
+template <int Words>
+int FixedBoard<Words>::getHeight() const
+{
+    return height_;
+}
+
+#endif
@@ -3,212 +3,158 @@
 #include <sstream>
 #include <vector>
 #include <cstring>
-#include "avlbst.h"
-#include <map>
+#include <cstdlib>
+#include <algorithm>
+#include "floorplan.h"
+#include "solver.h"
+#include "instance.h"
+#include "batch.h"
+#include "binformat.h"
+#include "stream.h"
+#include "daemon.h"
+#include "cache.h"
 
 using namespace std;
 
-struct Rectangle
+// Reads the optional flags in argv[first..]. --threads is only accepted
+// when threads is given. Returns false on anything it does not understand.
+bool parseOptions(int argc, char *argv[], int first, SolverOptions& opts, int* threads, string& cacheDir)
 {
-    int ID;
-    int length;
-    int height;
-};
-
-// Typedefs for you input and output map. Start with
-// std::map but once the backtracking search algorithm is working
-// try to use your AVL-tree map implementation by changing these
-// typedef's
-typedef AVLTree<int, Rectangle> InputMapType;
-typedef AVLTree<int, std::pair<int, int> > OutputMapType;
-
-// Allowed global variables: the dimensions of the grid
-int n; // X-dim size
-int m; // Y-dim size
-
-// No other global variables are allowed
-
-// A dummy operator << for Rectangles so the BST and AVL BST will
-// compile with their printRoot() implementations
-std::ostream& operator<<(std::ostream& os, const Rectangle& r)
-{
-    os << r.ID;
-    return os;
-}
-
-// A dummy operator << for pairs so the BST and AVL BST will
-// compile with their printRoot() implementations
-template <typename T, typename U>
-std::ostream& operator<<(std::ostream& os, const std::pair<T,U>& p)
-{
-    os << p.first << "," << p.second;
-    return os;
-}
-
-
-
-void printSolution(std::ostream& os, InputMapType& input, OutputMapType& output)
-{
-    for (OutputMapType::iterator it = output.begin(); it != output.end(); ++it)
-    {
-        InputMapType::iterator rbit = input.find(it->first);
-        os << it->first << " ";
-        os << it->second.first << " ";
-        os << it->second.second << " ";
-        os << rbit->second.length << " ";
-        os << rbit->second.height << endl;
-    }
-}
-
-// Changes the grid entries to their opposite values for the
-// rectangle r starting at x1,y1
-void flip(int x1, int y1, const Rectangle& r, vector<vector<bool> >& grid)
-{
-    for (int x = x1; x < x1+r.length; x++)
-    {
-        for (int y = y1; y < y1+r.height; y++) grid[x][y] = !grid[x][y];
-    }
-}
-
-//check if rectangle is within bounds of grid and if spaces on grid are already occupied or not
-bool gridcheck(int row, int col, InputMapType::iterator it, vector<vector<bool> > grid)
-{
-    //check if rectangle is within bounds of board
-    if(it->second.length + row > n || it->second.height + col > m)
-    {
-        return false;
-    }
-    //check if needed space for rectangle are available or already filled
-    for (int x = row; x < row+it->second.length; x++)
+    for (int i = first; i < argc; i++)
     {
-        for (int y = col; y < col+it->second.height; y++)
+        if(strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc)
         {
-            if(grid[x][y] == true)
-            {
-                return false;
-            }
+            opts.timeLimitMs = atoll(argv[++i]);
         }
-    }
-    return true;
-}
-
-// TODO: Write your backtracking search function here
-bool search(InputMapType::iterator it, vector<vector<bool> > grid, InputMapType::iterator end, OutputMapType &answer)
-{
-    if(it == end)
-    {
-        return true;
-    }
-    else
-    {
-        for(int i = 0; i < n; i++)
+        else if(strcmp(argv[i], "--node-limit") == 0 && i + 1 < argc)
         {
-            for(int j = 0; j < m; j++)
-            {
-                if(gridcheck(i,j,it, grid))
-                {
-                    flip(i, j, it->second, grid);
-                    //create a temp iterator so that we don't change the original iterator passed in
-                    //to the function in case we return
-                    InputMapType::iterator temp = it;
-                    if(search(++temp, grid, end,answer))
-                    {
-                        //succesfully placed the rectangle onto board, so insert into OutputMap
-                        pair<int, std::pair<int, int>> rect = make_pair(it->first, std::make_pair(i,j));
-                        answer.insert(rect);
-                        return true;
-                    }
-                    //unsuccessful in trying to fit rectangle onto current board state
-                    else
-                    {
-                        flip(i,j, it->second,grid);
-                    }
-                }
-            }
+            opts.nodeLimit = atoll(argv[++i]);
         }
-        //rotate the rectangle by switching its lenght and height and try everything again
-        int temp = it->second.height;
-        it->second.height = it->second.length;
-        it->second.length = temp;
-        for(int i = 0; i < n;i++)
+        else if(strcmp(argv[i], "--strip") == 0)
         {
-            for(int j = 0; j < m; j++)
+            opts.strip = true;
+        }
+        else if(strcmp(argv[i], "--min-area") == 0)
+        {
+            opts.minArea = true;
+        }
+        else if(strcmp(argv[i], "--no-heuristic") == 0)
+        {
+            opts.heuristic = false;
+        }
+        else if(strcmp(argv[i], "--lns") == 0 && i + 1 < argc)
+        {
+            opts.lnsIterations = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--restarts") == 0)
+        {
+            opts.restarts = true;
+        }
+        else if(strcmp(argv[i], "--portfolio") == 0)
+        {
+            opts.portfolio = true;
+        }
+        else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            opts.seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+        {
+            cacheDir = argv[++i];
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && threads != NULL && i + 1 < argc)
+        {
+            *threads = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+        {
+            opts.engine = argv[++i];
+            if(opts.engine != "grid" && opts.engine != "bstar" && opts.engine != "seqpair" &&
+               opts.engine != "slicing")
             {
-                if(gridcheck(i,j, it, grid))
-                {
-                    flip(i, j, it->second, grid);
-                    InputMapType::iterator temp = it;
-                    if(search(++temp,grid, end,answer))
-                    {
-                        pair<int, std::pair<int, int>> rect = make_pair(it->first, std::make_pair(i,j));
-                        answer.insert(rect);
-                        return true;
-                    }
-                    else
-                    {
-                        flip(i,j, it->second,grid);
-                    }
-                }
+                cout << "unknown engine " << opts.engine << endl;
+                return false;
             }
         }
+        else
+        {
+            cout << "unknown option " << argv[i] << endl;
+            return false;
+        }
     }
-    return false;
+    return true;
 }
 
-
-
-
 int main(int argc, char *argv[])
 {
-    if (argc < 3) {
+    if (argc > 1 && strcmp(argv[1], "--convert") == 0) {
+        string error;
+        if (argc < 4 || argc > 5) {
+            cout << "usage: floorplan --convert source destination [instances]" << endl;
+        }
+        else if (!convertFile(argv[2], argv[3], argc == 5 ? argv[4] : "", error)) {
+            cout << "cannot convert " << error << endl;
+        }
+        return 0;
+    }
+    if (argc == 3 && strcmp(argv[1], "--client") == 0) {
+        return runClient(argv[2], 0, 1, cerr) ? 0 : 1;
+    }
+    bool batch = argc > 1 && strcmp(argv[1], "--batch") == 0;
+    bool stream = argc > 1 && strcmp(argv[1], "--stream") == 0;
+    bool serve = argc > 1 && strcmp(argv[1], "--serve") == 0;
+    int first = batch ? 4 : stream ? 2 : 3;
+    if (argc < first) {
         cout << "please specify an input and output file";
         return 0;
     }
-    ifstream ifile(argv[1]);
-    //check if input file exists
-    if(ifile.fail())
+    SolverOptions opts;
+    int threads = 0;
+    string cacheDir;
+    if(!parseOptions(argc, argv, first, opts, batch || stream || serve ? &threads : NULL, cacheDir))
     {
-        cout << "invalid input file"<<endl;
+        cout << "usage: floorplan input output [--time-limit ms] [--node-limit nodes] [--strip | --min-area] [--no-heuristic] [--lns iterations] [--engine grid|bstar|seqpair|slicing]"
+             << " [--restarts] [--seed n] [--portfolio] [--cache dir]" << endl;
+        cout << "       floorplan --batch inputs outputs [--threads n] [options]" << endl;
+        cout << "       floorplan --stream [--threads n] [options] < inputs > outputs" << endl;
+        cout << "       floorplan --serve socket [--threads n] [options]" << endl;
+        cout << "       floorplan --client socket < inputs > outputs" << endl;
+        cout << "       floorplan --convert source destination [instances]" << endl;
         return 0;
     }
-    stringstream ss;
-    string line;
-    ofstream ofile(argv[2]);
-    int x;
-    getline(ifile, line);
-    ss << line;
-    ss >> n;
-    ss >> m;
-    ss >> x;
-
-    InputMapType input;
-    OutputMapType output;
-    for (int i = 0; i < x; i++) {
-        getline(ifile, line);
-        stringstream ss2(line);
-        Rectangle r;
-        ss2 >> r.ID;
-        ss2 >> r.length;
-        ss2 >> r.height;
-        input.insert(std::make_pair(r.ID, r));
+    if (serve) {
+        return runDaemon(argv[2], opts, threads, cacheDir, cout) ? 0 : 1;
     }
-    ifile.close();
-    vector<vector<bool> > grid;
-
-    for (int i = 0; i < n; i++)
+    //a cache without a directory would only help with repeats within a run
+    ResultCache cache(opts, cacheDir);
+    ResultCache* useCache = cacheDir.empty() ? NULL : &cache;
+    if (stream) {
+        return runStream(0, "stdin", cout, opts, threads, cerr, useCache) ? 0 : 1;
+    }
+    if (batch) {
+        if (!runBatch(argv[2], argv[3], opts, threads, cout, useCache)) {
+            cout << "invalid batch input or output" << endl;
+        }
+        return 0;
+    }
+    Instance instance;
+    bool binary;
+    string error;
+    //check if input file exists and is well formed
+    if(!loadInstance(argv[1], instance, binary, error))
     {
-        grid.push_back(vector<bool>(m, false));
+        cout << "invalid input file " << error << endl;
+        return 0;
     }
-    InputMapType::iterator it = input.begin();
-    bool solution_exists = false;
-
-    solution_exists = search(it, grid, input.end(), output);
+    ofstream ofile(argv[2], ios::binary);
 
-    if (!solution_exists) {
-        ofile << "No solution found.";
+    SolveResult result = solveCached(instance, opts, useCache);
+    //binary inputs get binary answers
+    if (binary) {
+        writeBinaryResult(ofile, instance, opts, result);
     }
     else {
-        printSolution(ofile, input, output);
+        writeResult(ofile, instance, opts, result);
     }
     ofile.close();
     return 0;
@@ -0,0 +1,24 @@
+#ifndef FLOORPLAN_H
+#define FLOORPLAN_H
+
+// Piece and placement types shared by the search in solver.cpp and the
+// packing heuristics.
+
+struct Rectangle
+{
+    int ID;
+    int length;
+    int height;
+};
+
+// A piece as it sits on the board, orientation included
+struct Placement
+{
+    int ID;
+    int x;
+    int y;
+    int length;
+    int height;
+};
+
+#endif
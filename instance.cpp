@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <climits>
+#include <sstream>
+#include <string>
+#include "instance.h"
+#include "mappedfile.h"
+#include "binformat.h"
+
+using namespace std;
+
+InstanceParser::InstanceParser(const char* begin, const char* end, int firstLine) :
+    pos_(begin), end_(end), lineStart_(begin), line_(firstLine), truncated_(false)
+{
+
+}
+
+bool InstanceParser::next(Instance& instance)
+{
+    skipBlankLines();
+    if(pos_ == end_)
+    {
+        return false;
+    }
+    int count;
+    if(!readNumber(instance.width, 1, "board width") || !readNumber(instance.height, 1, "board height") ||
+       !readNumber(count, 0, "piece count") || !endLine())
+    {
+        return false;
+    }
+    instance.pieces.clear();
+    //a bogus count must not reserve more than the rest of the input could hold
+    instance.pieces.reserve(std::min<size_t>(count, (end_ - pos_) / 6 + 1));
+    for (int i = 0; i < count; i++)
+    {
+        if(pos_ == end_)
+        {
+            ostringstream message;
+            message << "input ends after " << i << " of " << count << " pieces";
+            return fail(message.str(), true);
+        }
+        Rectangle r;
+        if(!readNumber(r.ID, INT_MIN, "piece ID") || !readNumber(r.length, 1, "piece length") ||
+           !readNumber(r.height, 1, "piece height") || !endLine())
+        {
+            return false;
+        }
+        instance.pieces.push_back(r);
+    }
+    return true;
+}
+
+bool InstanceParser::atEnd()
+{
+    skipBlankLines();
+    return pos_ == end_;
+}
+
+const std::string& InstanceParser::error() const
+{
+    return error_;
+}
+
+bool InstanceParser::truncated() const
+{
+    return truncated_;
+}
+
+const char* InstanceParser::position() const
+{
+    return pos_;
+}
+
+void InstanceParser::skipBlankLines()
+{
+    const char* p = pos_;
+    while(p != end_ && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+    {
+        if(*p == '\n')
+        {
+            line_++;
+            lineStart_ = p + 1;
+        }
+        p++;
+    }
+    pos_ = p;
+}
+
+// Reads an optionally signed decimal number no smaller than min, after any
+// spaces but without leaving the line
+bool InstanceParser::readNumber(int& value, int min, const char* what)
+{
+    const char* p = pos_;
+    while(p != end_ && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    pos_ = p;
+    bool negative = p != end_ && *p == '-';
+    if(p != end_ && (*p == '-' || *p == '+'))
+    {
+        p++;
+    }
+    if(p == end_ || *p < '0' || *p > '9')
+    {
+        return fail(string("expected ") + what, p == end_);
+    }
+    long long number = 0;
+    while(p != end_ && *p >= '0' && *p <= '9')
+    {
+        number = number * 10 + (*p - '0');
+        if(number > (long long)INT_MAX + 1)
+        {
+            return fail(string(what) + " out of range");
+        }
+        p++;
+    }
+    number = negative ? -number : number;
+    if(number > INT_MAX || number < min)
+    {
+        return fail(string(what) + (number < min ? " too small" : " out of range"));
+    }
+    value = number;
+    pos_ = p;
+    return true;
+}
+
+// Checks that nothing but spaces follows on the line and moves to the next
+bool InstanceParser::endLine()
+{
+    const char* p = pos_;
+    while(p != end_ && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+        p++;
+    }
+    pos_ = p;
+    if(p == end_)
+    {
+        return true;
+    }
+    if(*p != '\n')
+    {
+        return fail("unexpected text after the third number");
+    }
+    pos_ = p + 1;
+    lineStart_ = pos_;
+    line_++;
+    return true;
+}
+
+bool InstanceParser::fail(const std::string& message, bool truncated)
+{
+    truncated_ = truncated;
+    ostringstream os;
+    os << line_ << ":" << (pos_ - lineStart_) + 1 << ": " << message;
+    error_ = os.str();
+    return false;
+}
+
+// Writes value in decimal at out and returns the end of what it wrote
+char* formatNumber(char* out, int value)
+{
+    unsigned magnitude = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+    if(value < 0)
+    {
+        *out++ = '-';
+    }
+    char digits[10];
+    int count = 0;
+    do
+    {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    }
+    while(magnitude > 0);
+    while(count > 0)
+    {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+bool loadInstance(const std::string& path, Instance& instance, bool& binary, std::string& error)
+{
+    MappedFile file;
+    if(!file.open(path))
+    {
+        error = path + ": cannot be read";
+        return false;
+    }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    binary = isBinaryInstance(begin, end);
+    if(binary)
+    {
+        BinaryInstanceReader reader(begin, end);
+        if(!reader.next(instance))
+        {
+            error = path + ": " + reader.error();
+            return false;
+        }
+        return true;
+    }
+    InstanceParser parser(begin, end);
+    if(!parser.next(instance))
+    {
+        error = path + ":" + (parser.error().empty() ? string(" no instance in the file") : parser.error());
+        return false;
+    }
+    return true;
+}
+
+void writeInstance(std::ostream& os, const Instance& instance)
+{
+    vector<char> buffer(WRITE_BUFFER_SIZE);
+    char* out = &buffer[0];
+    char* limit = out + WRITE_BUFFER_SIZE - 64;
+    out = formatNumber(out, instance.width);
+    *out++ = ' ';
+    out = formatNumber(out, instance.height);
+    *out++ = ' ';
+    out = formatNumber(out, (int)instance.pieces.size());
+    *out++ = '\n';
+    for (size_t i = 0; i < instance.pieces.size(); i++)
+    {
+        if(out > limit)
+        {
+            os.write(&buffer[0], out - &buffer[0]);
+            out = &buffer[0];
+        }
+        const Rectangle& r = instance.pieces[i];
+        out = formatNumber(out, r.ID);
+        *out++ = ' ';
+        out = formatNumber(out, r.length);
+        *out++ = ' ';
+        out = formatNumber(out, r.height);
+        *out++ = '\n';
+    }
+    os.write(&buffer[0], out - &buffer[0]);
+}
+
+bool isInstanceHeader(const std::string& line)
+{
+    stringstream ss(line);
+    int width, height, count;
+    string rest;
+    return (ss >> width >> height >> count) && !(ss >> rest);
+}
+
+bool placementLess(const Placement& a, const Placement& b)
+{
+    return a.ID < b.ID;
+}
+
+void printPlacements(std::ostream& os, const std::vector<Placement>& placed)
+{
+    //solutions from the search are already in ID order, so only copy and
+    //sort the ones that are not
+    const vector<Placement>* list = &placed;
+    vector<Placement> sorted;
+    if(!is_sorted(placed.begin(), placed.end(), placementLess))
+    {
+        sorted = placed;
+        sort(sorted.begin(), sorted.end(), placementLess);
+        list = &sorted;
+    }
+    vector<char> buffer(WRITE_BUFFER_SIZE);
+    char* out = &buffer[0];
+    //a line takes at most 5 numbers of 11 characters and their separators
+    char* limit = out + WRITE_BUFFER_SIZE - 64;
+    for (size_t i = 0; i < list->size(); i++)
+    {
+        if(out > limit)
+        {
+            os.write(&buffer[0], out - &buffer[0]);
+            out = &buffer[0];
+        }
+        const Placement& p = (*list)[i];
+        out = formatNumber(out, p.ID);
+        *out++ = ' ';
+        out = formatNumber(out, p.x);
+        *out++ = ' ';
+        out = formatNumber(out, p.y);
+        *out++ = ' ';
+        out = formatNumber(out, p.length);
+        *out++ = ' ';
+        out = formatNumber(out, p.height);
+        *out++ = '\n';
+    }
+    os.write(&buffer[0], out - &buffer[0]);
+}
+
+// Writes the status line that ends the output in anytime mode
+void printStatus(std::ostream& os, bool complete, const vector<Placement>& best, bool exhausted,
+                 int pieces, long long area)
+{
+    if(complete)
+    {
+        os << "Status: complete" << endl;
+        return;
+    }
+    long long placedArea = 0;
+    for (size_t i = 0; i < best.size(); i++)
+    {
+        placedArea += (long long)best[i].length * best[i].height;
+    }
+    os << "Status: partial, placed " << best.size() << " of " << pieces << " pieces ("
+       << placedArea << " of " << area << " area), ";
+    if(exhausted)
+    {
+        os << "budget exhausted" << endl;
+    }
+    else
+    {
+        os << "no complete solution exists" << endl;
+    }
+}
+
+OutputMode outputMode(const SolverOptions& opts)
+{
+    if(opts.engine != "grid")
+    {
+        return OUTPUT_ENGINE;
+    }
+    if(opts.strip)
+    {
+        return OUTPUT_STRIP;
+    }
+    if(opts.minArea)
+    {
+        return OUTPUT_MIN_AREA;
+    }
+    return opts.timeLimitMs > 0 || opts.nodeLimit > 0 ? OUTPUT_ANYTIME : OUTPUT_SEARCH;
+}
+
+void writeResult(std::ostream& os, const Instance& instance, const SolverOptions& opts,
+                 const SolveResult& result)
+{
+    writeResult(os, instance, outputMode(opts), result);
+}
+
+void writeResult(std::ostream& os, const Instance& instance, OutputMode mode, const SolveResult& result)
+{
+    int n = instance.width;
+    int m = instance.height;
+    bool anytime = mode == OUTPUT_ANYTIME;
+    long long totalArea = 0;
+    for (size_t i = 0; i < instance.pieces.size(); i++)
+    {
+        totalArea += (long long)instance.pieces[i].length * instance.pieces[i].height;
+    }
+
+    if (mode == OUTPUT_ENGINE) {
+        printPlacements(os, result.placements);
+        os << "Board: " << result.width << " x " << result.height << endl;
+        if (result.width <= n && result.height <= m) {
+            os << "Status: fits " << n << " x " << m << endl;
+        }
+        else {
+            os << "Status: exceeds " << n << " x " << m << endl;
+        }
+    }
+    else if (mode == OUTPUT_STRIP || mode == OUTPUT_MIN_AREA) {
+        if (!result.complete) {
+            os << "No solution found.";
+        }
+        else {
+            printPlacements(os, result.placements);
+            os << "Board: " << result.width << " x " << result.height << endl;
+            os << (result.optimal ? "Status: optimal" : "Status: best found, budget exhausted before proving optimality") << endl;
+        }
+    }
+    else if (!result.reason.empty()) {
+        if (anytime) {
+            os << "Status: infeasible, " << result.reason << endl;
+        }
+        else {
+            os << "No solution found." << endl;
+            os << "Reason: " << result.reason << endl;
+        }
+    }
+    else if (anytime) {
+        printPlacements(os, result.placements);
+        printStatus(os, result.complete, result.placements, result.exhausted, instance.pieces.size(), totalArea);
+    }
+    else if (!result.complete) {
+        os << "No solution found.";
+    }
+    else {
+        printPlacements(os, result.placements);
+    }
+}
+
+void writeStreamAnswer(std::ostream& os, size_t index, const std::string& text)
+{
+    os << "Instance " << index + 1 << endl << text;
+    //a few outputs end without a newline of their own
+    if(text.empty() || text[text.size() - 1] != '\n')
+    {
+        os << endl;
+    }
+}
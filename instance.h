@@ -0,0 +1,112 @@
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "floorplan.h"
+#include "solver.h"
+
+/**
+* One puzzle as it appears in an input file: a header line "width height
+* count" followed by count lines of "ID length height".
+*/
+struct Instance
+{
+    int width;
+    int height;
+    std::vector<Rectangle> pieces;
+};
+
+/**
+* Reads instances straight out of a character buffer, such as a
+* MappedFile, without copying lines or going through streams. Numbers are
+* parsed in place. The header and every piece must sit on a line of their
+* own, each with exactly three numbers; a negative count, a side below 1,
+* anything else on a line, or input that ends before count pieces are read
+* is an error, reported with its line and column. A count of 0 is an
+* instance with nothing to place.
+*/
+class InstanceParser
+{
+public:
+    // firstLine numbers the lines of a buffer that starts part way into
+    // a larger input
+    InstanceParser(const char* begin, const char* end, int firstLine = 1);
+
+    // Parses the next instance, skipping blank lines before it. Returns
+    // false at the end of the input or on an error, which error() then
+    // describes.
+    bool next(Instance& instance);
+
+    // True once only blank lines are left
+    bool atEnd();
+
+    // "line:column: message" for the last error, or empty
+    const std::string& error() const;
+
+    // The last error came from running out of input, so more of it might
+    // still complete the instance
+    bool truncated() const;
+
+    // Where parsing stopped: just after the last instance read, or at the
+    // error
+    const char* position() const;
+
+private:
+    void skipBlankLines();
+    bool readNumber(int& value, int min, const char* what);
+    bool endLine();
+    bool fail(const std::string& message, bool truncated = false);
+
+    const char* pos_;
+    const char* end_;
+    const char* lineStart_;
+    int line_;
+    std::string error_;
+    bool truncated_;
+};
+
+// Maps the file at path and reads the instance at its start, in text or
+// in the binary format of binformat.h, which binary then tells. On failure
+// error says why, prefixed with the path.
+bool loadInstance(const std::string& path, Instance& instance, bool& binary, std::string& error);
+
+// Writes an instance in the text input format
+void writeInstance(std::ostream& os, const Instance& instance);
+
+// Checks whether line could be the header of an instance
+bool isInstanceHeader(const std::string& line);
+
+// Bytes of output formatted before each write to the stream
+const size_t WRITE_BUFFER_SIZE = 1 << 16;
+
+// Prints a list of placements, sorted by ID, one "ID x y length height"
+// line each. The lines are formatted into a buffer that is written out in
+// blocks of WRITE_BUFFER_SIZE, never flushed line by line.
+void printPlacements(std::ostream& os, const std::vector<Placement>& placed);
+
+// The solving modes that write their answers differently
+enum OutputMode
+{
+    OUTPUT_SEARCH = 0,
+    // the search with a time or node limit
+    OUTPUT_ANYTIME = 1,
+    OUTPUT_STRIP = 2,
+    OUTPUT_MIN_AREA = 3,
+    // any of the annealing engines
+    OUTPUT_ENGINE = 4
+};
+
+OutputMode outputMode(const SolverOptions& opts);
+
+// Writes the answer for instance in the output format of mode
+void writeResult(std::ostream& os, const Instance& instance, OutputMode mode, const SolveResult& result);
+void writeResult(std::ostream& os, const Instance& instance, const SolverOptions& opts,
+                 const SolveResult& result);
+
+// Writes the answer to instance k (from 0) of a multi-instance stream: an
+// "Instance k+1" line followed by text, ending with a newline
+void writeStreamAnswer(std::ostream& os, size_t index, const std::string& text);
+
+#endif
@@ -0,0 +1,73 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mappedfile.h"
+
+MappedFile::MappedFile() : map_(NULL), size_(0)
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map != MAP_FAILED)
+        {
+            //the parsers walk the buffer front to back exactly once
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            map_ = map;
+            size_ = info.st_size;
+            ::close(fd);
+            return true;
+        }
+    }
+    const size_t BLOCK = 1 << 16;
+    ssize_t got;
+    do
+    {
+        size_t used = buffer_.size();
+        buffer_.resize(used + BLOCK);
+        got = read(fd, &buffer_[used], BLOCK);
+        buffer_.resize(used + (got > 0 ? got : 0));
+    }
+    while(got > 0);
+    ::close(fd);
+    size_ = buffer_.size();
+    return got == 0;
+}
+
+void MappedFile::close()
+{
+    if(map_ != NULL)
+    {
+        munmap(map_, size_);
+        map_ = NULL;
+    }
+    buffer_.clear();
+    size_ = 0;
+}
+
+const char* MappedFile::data() const
+{
+    return map_ != NULL ? static_cast<const char*>(map_) : buffer_.data();
+}
+
+size_t MappedFile::size() const
+{
+    return size_;
+}
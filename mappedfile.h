@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+* The whole contents of a file as one read-only buffer. Regular files are
+* memory-mapped so that nothing is copied; anything that cannot be mapped,
+* such as a pipe, is read into memory in large blocks instead.
+*/
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Maps path, releasing any file held before. Returns false if it cannot
+    // be opened or read.
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const;
+    size_t size() const;
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // the mapping, or NULL if the contents are in buffer_
+    void* map_;
+    size_t size_;
+    std::string buffer_;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "instance.h"
+
+using namespace std;
+
+int failures = 0;
+
+// Parses text as one instance and checks that it is accepted, or rejected
+// with the error expected
+void expect(const string& text, const string& expected)
+{
+    InstanceParser parser(text.data(), text.data() + text.size());
+    Instance instance;
+    bool parsed = parser.next(instance);
+    string error = parsed ? "" : parser.error();
+    if(error != expected)
+    {
+        cout << "FAIL: \"" << text << "\" gave \"" << error << "\", expected \"" << expected << "\"" << endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    expect("4 3 1\n1 2 2\n", "");
+    expect("4 3 2\n1 2 2\n2 1 3\n", "");
+    expect("4 3 0\n", "");
+    expect("4 3 0\n\n4 3 1\n1 2 2\n", "");
+    expect("4 3 -1\n", "1:5: piece count too small");
+    expect("0 3 1\n1 2 2\n", "1:1: board width too small");
+    expect("4 3 1\n1 0 2\n", "2:3: piece length too small");
+    expect("4 3 2\n1 2 2\n", "3:1: input ends after 1 of 2 pieces");
+    expect("4 3 1\n1 2 2 5\n", "2:7: unexpected text after the third number");
+    if(failures > 0)
+    {
+        return 1;
+    }
+    cout << "parser tests passed" << endl;
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include "quadtree.h"
+
+/**
+* Builds an empty quadtree whose root square is the smallest power of two
+* covering both board dimensions.
+*/
+QuadTree::QuadTree(int width, int height) :
+    width_(width), height_(height), size_(1), live_(1)
+{
+    while(size_ < width_ || size_ < height_)
+    {
+        size_ *= 2;
+    }
+    QuadNode root;
+    root.state = EMPTY;
+    root.child = -1;
+    nodes_.push_back(root);
+}
+
+void QuadTree::fill(int x, int y, int length, int height)
+{
+    assign(0, 0, 0, size_, x, y, x+length, y+height, FULL);
+}
+
+void QuadTree::clear(int x, int y, int length, int height)
+{
+    assign(0, 0, 0, size_, x, y, x+length, y+height, EMPTY);
+}
+
+bool QuadTree::isEmpty(int x, int y, int length, int height) const
+{
+    return emptyHelp(0, 0, 0, size_, x, y, x+length, y+height);
+}
+
+bool QuadTree::get(int x, int y) const
+{
+    int node = 0;
+    int nx = 0;
+    int ny = 0;
+    int size = size_;
+    //walk down towards the cell until we hit a uniform block
+    while(nodes_[node].state == MIXED)
+    {
+        size /= 2;
+        int quad = 0;
+        if(x >= nx + size)
+        {
+            nx += size;
+            quad += 1;
+        }
+        if(y >= ny + size)
+        {
+            ny += size;
+            quad += 2;
+        }
+        node = nodes_[node].child + quad;
+    }
+    return nodes_[node].state == FULL;
+}
+
+int QuadTree::getWidth() const
+{
+    return width_;
+}
+
+int QuadTree::getHeight() const
+{
+    return height_;
+}
+
+size_t QuadTree::nodeCount() const
+{
+    return live_;
+}
+
+/**
+* Sets every cell of [x1, x2) x [y1, y2) inside the block rooted at node
+* to state, splitting uniform blocks that are only partially covered and
+* merging children back together when they all end up with the same state.
+*/
+void QuadTree::assign(int node, int nx, int ny, int size,
+                      int x1, int y1, int x2, int y2, char state)
+{
+    //block does not intersect the rectangle
+    if(x2 <= nx || y2 <= ny || x1 >= nx + size || y1 >= ny + size)
+    {
+        return;
+    }
+    //block is already uniformly the target state
+    if(nodes_[node].state == state)
+    {
+        return;
+    }
+    //block is entirely covered by the rectangle
+    if(x1 <= nx && y1 <= ny && x2 >= nx + size && y2 >= ny + size)
+    {
+        releaseChildren(node);
+        nodes_[node].state = state;
+        return;
+    }
+    if(nodes_[node].state != MIXED)
+    {
+        //allocChildren may move nodes_, so don't hold a reference across it
+        int child = allocChildren(nodes_[node].state);
+        nodes_[node].child = child;
+        nodes_[node].state = MIXED;
+    }
+    int half = size / 2;
+    int child = nodes_[node].child;
+    assign(child, nx, ny, half, x1, y1, x2, y2, state);
+    assign(child + 1, nx + half, ny, half, x1, y1, x2, y2, state);
+    assign(child + 2, nx, ny + half, half, x1, y1, x2, y2, state);
+    assign(child + 3, nx + half, ny + half, half, x1, y1, x2, y2, state);
+    //collapse the children if they have all become the same uniform state
+    char first = nodes_[child].state;
+    if(first != MIXED && nodes_[child+1].state == first &&
+       nodes_[child+2].state == first && nodes_[child+3].state == first)
+    {
+        releaseChildren(node);
+        nodes_[node].state = first;
+    }
+}
+
+bool QuadTree::emptyHelp(int node, int nx, int ny, int size,
+                         int x1, int y1, int x2, int y2) const
+{
+    if(x2 <= nx || y2 <= ny || x1 >= nx + size || y1 >= ny + size)
+    {
+        return true;
+    }
+    if(nodes_[node].state != MIXED)
+    {
+        return nodes_[node].state == EMPTY;
+    }
+    int half = size / 2;
+    int child = nodes_[node].child;
+    return emptyHelp(child, nx, ny, half, x1, y1, x2, y2) &&
+           emptyHelp(child + 1, nx + half, ny, half, x1, y1, x2, y2) &&
+           emptyHelp(child + 2, nx, ny + half, half, x1, y1, x2, y2) &&
+           emptyHelp(child + 3, nx + half, ny + half, half, x1, y1, x2, y2);
+}
+
+/**
+* Hands out a block of four children initialised to state, reusing a
+* previously released block when one is available.
+*/
+int QuadTree::allocChildren(char state)
+{
+    int child;
+    if(!freeBlocks_.empty())
+    {
+        child = freeBlocks_.back();
+        freeBlocks_.pop_back();
+    }
+    else
+    {
+        child = nodes_.size();
+        nodes_.resize(nodes_.size() + 4);
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        nodes_[child + i].state = state;
+        nodes_[child + i].child = -1;
+    }
+    live_ += 4;
+    return child;
+}
+
+void QuadTree::releaseChildren(int node)
+{
+    int child = nodes_[node].child;
+    if(child < 0)
+    {
+        return;
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        releaseChildren(child + i);
+    }
+    freeBlocks_.push_back(child);
+    nodes_[node].child = -1;
+    live_ -= 4;
+}
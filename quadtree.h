@@ -0,0 +1,61 @@
+#ifndef QUADTREE_H
+#define QUADTREE_H
+
+#include <vector>
+#include <cstddef>
+
+/**
+* A region quadtree over a width x height board of cells. Every node covers a
+* square block of the board and is either entirely EMPTY, entirely FULL, or
+* MIXED (in which case it owns four children). Uniform regions collapse back
+* into a single node, so memory grows with the length of the boundary between
+* occupied and free space instead of with the area of the board.
+*
+* Cells are addressed the same way as the BitBoard grid used by
+* search(): x runs over [0, width) and y runs over [0, height).
+*/
+class QuadTree
+{
+public:
+    QuadTree(int width, int height);
+
+    // Rectangle updates and queries over [x, x+length) x [y, y+height)
+    void fill(int x, int y, int length, int height);
+    void clear(int x, int y, int length, int height);
+    bool isEmpty(int x, int y, int length, int height) const;
+
+    // Returns true if the single cell (x, y) is occupied
+    bool get(int x, int y) const;
+
+    int getWidth() const;
+    int getHeight() const;
+
+    // Number of live nodes, useful for keeping an eye on memory use
+    size_t nodeCount() const;
+
+private:
+    enum State { EMPTY, FULL, MIXED };
+
+    struct QuadNode
+    {
+        char state;
+        // index of the first of four consecutive children in nodes_, or -1
+        int child;
+    };
+
+    void assign(int node, int nx, int ny, int size,
+                int x1, int y1, int x2, int y2, char state);
+    bool emptyHelp(int node, int nx, int ny, int size,
+                   int x1, int y1, int x2, int y2) const;
+    int allocChildren(char state);
+    void releaseChildren(int node);
+
+    std::vector<QuadNode> nodes_;
+    std::vector<int> freeBlocks_;
+    int width_;
+    int height_;
+    int size_;
+    size_t live_;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include "seqpair.h"
+#include "anneal.h"
+
+/**
+* Starts with both sequences in input order, i.e. every module in one row.
+*/
+SequencePair::SequencePair(const std::vector<Rectangle>& pieces, int outlineWidth, int outlineHeight) :
+    pieces_(pieces), width_(0), height_(0), lastMove_(ROTATE), lastA_(0), lastB_(0),
+    savedWidth_(0), savedHeight_(0), moduleArea_(0),
+    outlineWidth_(outlineWidth), outlineHeight_(outlineHeight)
+{
+    int count = pieces_.size();
+    for (int i = 0; i < count; i++)
+    {
+        positive_.push_back(i);
+        negative_.push_back(i);
+        negativeIndex_.push_back(i);
+        moduleArea_ += (long long)pieces_[i].length * pieces_[i].height;
+    }
+    rotated_.assign(count, 0);
+    x_.resize(count);
+    y_.resize(count);
+    pack();
+    keepBest();
+}
+
+int SequencePair::size() const
+{
+    return pieces_.size();
+}
+
+double SequencePair::cost() const
+{
+    return packingCost(width_, height_, moduleArea_, outlineWidth_, outlineHeight_);
+}
+
+int SequencePair::getWidth() const
+{
+    return width_;
+}
+
+int SequencePair::getHeight() const
+{
+    return height_;
+}
+
+int SequencePair::moduleLength(int module) const
+{
+    return rotated_[module] ? pieces_[module].height : pieces_[module].length;
+}
+
+int SequencePair::moduleHeight(int module) const
+{
+    return rotated_[module] ? pieces_[module].length : pieces_[module].height;
+}
+
+void SequencePair::swapBoth(int a, int b)
+{
+    std::swap(positive_[a], positive_[b]);
+    int na = negativeIndex_[positive_[a]];
+    int nb = negativeIndex_[positive_[b]];
+    std::swap(negative_[na], negative_[nb]);
+    negativeIndex_[negative_[na]] = na;
+    negativeIndex_[negative_[nb]] = nb;
+}
+
+void SequencePair::perturb(std::mt19937& rng)
+{
+    savedWidth_ = width_;
+    savedHeight_ = height_;
+    int count = size();
+    if(count == 0)
+    {
+        return;
+    }
+    lastMove_ = count > 1 ? Move(rng() % 3) : ROTATE;
+    lastA_ = rng() % count;
+    lastB_ = rng() % count;
+    if(lastMove_ == SWAP_POSITIVE)
+    {
+        std::swap(positive_[lastA_], positive_[lastB_]);
+    }
+    else if(lastMove_ == SWAP_BOTH)
+    {
+        swapBoth(lastA_, lastB_);
+    }
+    else
+    {
+        rotated_[lastA_] = !rotated_[lastA_];
+    }
+    pack();
+}
+
+void SequencePair::undo()
+{
+    if(size() == 0)
+    {
+        return;
+    }
+    //every move is its own inverse
+    if(lastMove_ == SWAP_POSITIVE)
+    {
+        std::swap(positive_[lastA_], positive_[lastB_]);
+    }
+    else if(lastMove_ == SWAP_BOTH)
+    {
+        //swapBoth looks the modules up through positive_, which now has them
+        //at each other's slots, so the same call puts everything back
+        swapBoth(lastA_, lastB_);
+    }
+    else
+    {
+        rotated_[lastA_] = !rotated_[lastA_];
+    }
+    //coordinates are left stale; placements() packs again before using them
+    width_ = savedWidth_;
+    height_ = savedHeight_;
+}
+
+void SequencePair::keepBest()
+{
+    bestPositive_ = positive_;
+    bestNegative_ = negative_;
+    bestRotated_ = rotated_;
+}
+
+void SequencePair::restoreBest()
+{
+    positive_ = bestPositive_;
+    negative_ = bestNegative_;
+    rotated_ = bestRotated_;
+    for (int i = 0; i < size(); i++)
+    {
+        negativeIndex_[negative_[i]] = i;
+    }
+    pack();
+}
+
+void SequencePair::placements(std::vector<Placement>& placed)
+{
+    pack();
+    placed.clear();
+    for (int i = 0; i < size(); i++)
+    {
+        Placement p = {pieces_[i].ID, x_[i], y_[i], moduleLength(i), moduleHeight(i)};
+        placed.push_back(p);
+    }
+}
+
+void SequencePair::pack()
+{
+    width_ = longestPath(true, x_);
+    height_ = longestPath(false, y_);
+}
+
+/**
+* One weighted-LCS pass. For x the modules are taken in positive order, for
+* y in reverse positive order; either way the modules already seen with a
+* smaller negative index are exactly the ones that must come before (left
+* of, or below) the current one, so its coordinate is the largest finish
+* among them. Finishes are kept in a Fenwick tree over the negative index,
+* which answers that prefix maximum and takes each new finish in O(log n)
+* with no allocation. Returns the extent.
+*/
+int SequencePair::longestPath(bool horizontal, std::vector<int>& coord)
+{
+    int count = size();
+    //prefixMax_[k] is the largest finish over negative indices
+    //(k - lowbit(k), k - 1], with k 1-based
+    prefixMax_.assign(count + 1, 0);
+    int extent = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int module = horizontal ? positive_[i] : positive_[count - 1 - i];
+        int key = negativeIndex_[module];
+        int start = 0;
+        for (int k = key; k > 0; k -= k & -k)
+        {
+            start = std::max(start, prefixMax_[k]);
+        }
+        int finish = start + (horizontal ? moduleLength(module) : moduleHeight(module));
+        coord[module] = start;
+        extent = std::max(extent, finish);
+        for (int k = key + 1; k <= count; k += k & -k)
+        {
+            prefixMax_[k] = std::max(prefixMax_[k], finish);
+        }
+    }
+    return extent;
+}
@@ -0,0 +1,78 @@
+#ifndef SEQPAIR_H
+#define SEQPAIR_H
+
+#include <vector>
+#include <random>
+#include "floorplan.h"
+
+/**
+* A sequence-pair floorplan: two orderings (positive, negative) of the
+* modules. Module a is left of b if a comes before b in both sequences, and
+* below b if a comes after b in positive but before it in negative.
+*
+* Coordinates come from two weighted longest-common-subsequence passes. Each
+* pass keeps a Fenwick tree of prefix maxima over positions in the negative
+* sequence, so a module's coordinate is the maximum just before its own
+* position and the whole evaluation is O(n log n). Moves swap two
+* modules in positive only, swap them in both sequences, or rotate one.
+* It satisfies the Plan interface of anneal().
+*/
+class SequencePair
+{
+public:
+    // An outline of 0 x 0 means minimise area with no fixed outline
+    SequencePair(const std::vector<Rectangle>& pieces, int outlineWidth, int outlineHeight);
+
+    int size() const;
+    double cost() const;
+    void perturb(std::mt19937& rng);
+    void undo();
+    void keepBest();
+    void restoreBest();
+
+    // Bounding box of the current packing
+    int getWidth() const;
+    int getHeight() const;
+
+    // Coordinates of every module in the current packing
+    void placements(std::vector<Placement>& placed);
+
+private:
+    enum Move { SWAP_POSITIVE, SWAP_BOTH, ROTATE };
+
+    void pack();
+    int longestPath(bool horizontal, std::vector<int>& coord);
+    void swapBoth(int a, int b);
+    int moduleLength(int module) const;
+    int moduleHeight(int module) const;
+
+    std::vector<Rectangle> pieces_;
+    std::vector<int> positive_;
+    std::vector<int> negative_;
+    // where each module sits in negative_
+    std::vector<int> negativeIndex_;
+    std::vector<char> rotated_;
+    std::vector<int> x_;
+    std::vector<int> y_;
+    // scratch Fenwick tree for longestPath()
+    std::vector<int> prefixMax_;
+    int width_;
+    int height_;
+
+    // enough to take back the last move
+    Move lastMove_;
+    int lastA_;
+    int lastB_;
+    int savedWidth_;
+    int savedHeight_;
+
+    std::vector<int> bestPositive_;
+    std::vector<int> bestNegative_;
+    std::vector<char> bestRotated_;
+
+    long long moduleArea_;
+    int outlineWidth_;
+    int outlineHeight_;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include "skyline.h"
+
+Skyline::Skyline(int width) : contour_(width), width_(width)
+{
+
+}
+
+/**
+* Tries the piece with its left edge at the start of every segment. The
+* piece rests on the highest segment under it, which the contour's index
+* finds; among the spots that fit, the one with the lowest top edge wins,
+* then the leftmost.
+*/
+bool Skyline::findPosition(int length, int height, int maxHeight, int& bestX, int& bestY) const
+{
+    bool found = false;
+    long long bestTop = 0;
+    for (const Contour::Segment* s = contour_.first(); s != NULL; s = s->next)
+    {
+        int x = s->x;
+        if(x + length > width_)
+        {
+            break;
+        }
+        int y = contour_.maxHeight(x, x + length);
+        long long top = (long long)y + height;
+        if(top > maxHeight)
+        {
+            continue;
+        }
+        if(!found || top < bestTop || (top == bestTop && x < bestX))
+        {
+            found = true;
+            bestTop = top;
+            bestX = x;
+            bestY = y;
+        }
+    }
+    return found;
+}
+
+void Skyline::place(int x, int y, int length, int height)
+{
+    contour_.raise(x, x + length, y + height);
+}
+
+namespace
+{
+
+bool largerFirst(const Rectangle& a, const Rectangle& b)
+{
+    long long areaA = (long long)a.length * a.height;
+    long long areaB = (long long)b.length * b.height;
+    if(areaA != areaB)
+    {
+        return areaA > areaB;
+    }
+    return std::max(a.length, a.height) > std::max(b.length, b.height);
+}
+
+}
+
+bool skylinePack(const std::vector<Rectangle>& pieces, int width, int height,
+                 std::vector<Placement>& placed, std::vector<int>& failed)
+{
+    std::vector<Rectangle> order(pieces);
+    std::stable_sort(order.begin(), order.end(), largerFirst);
+    Skyline skyline(width);
+    placed.clear();
+    failed.clear();
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        const Rectangle& r = order[i];
+        int x = 0;
+        int y = 0;
+        int rx = 0;
+        int ry = 0;
+        bool upright = skyline.findPosition(r.length, r.height, height, x, y);
+        bool rotated = r.length != r.height && skyline.findPosition(r.height, r.length, height, rx, ry);
+        if(!upright && !rotated)
+        {
+            failed.push_back(r.ID);
+            continue;
+        }
+        Placement p = {r.ID, x, y, r.length, r.height};
+        //take the rotation if it ends up lower, or leftmost on a tie
+        if(rotated && (!upright || (long long)ry + r.length < (long long)y + r.height ||
+                       ((long long)ry + r.length == (long long)y + r.height && rx < x)))
+        {
+            p.x = rx;
+            p.y = ry;
+            p.length = r.height;
+            p.height = r.length;
+        }
+        skyline.place(p.x, p.y, p.length, p.height);
+        placed.push_back(p);
+    }
+    return failed.empty();
+}
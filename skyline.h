@@ -0,0 +1,35 @@
+#ifndef SKYLINE_H
+#define SKYLINE_H
+
+#include <vector>
+#include "floorplan.h"
+#include "contour.h"
+
+/**
+* Bottom-left placement on top of a Contour covering [0, width).
+*/
+class Skyline
+{
+public:
+    Skyline(int width);
+
+    // Finds the best spot for a length x height piece whose top stays at or
+    // below maxHeight. Returns false if there is none.
+    bool findPosition(int length, int height, int maxHeight, int& bestX, int& bestY) const;
+
+    // Raises the skyline over [x, x+length) to y+height
+    void place(int x, int y, int length, int height);
+
+private:
+    Contour contour_;
+    int width_;
+};
+
+// Skyline bottom-left packing of pieces onto a width x height board, largest
+// pieces first, trying both orientations. Pieces that do not fit are skipped
+// and their IDs returned in failed, so placed always holds a valid (possibly
+// partial) packing. Returns true if every piece was placed.
+bool skylinePack(const std::vector<Rectangle>& pieces, int width, int height,
+                 std::vector<Placement>& placed, std::vector<int>& failed);
+
+#endif
@@ -0,0 +1,517 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "slicing.h"
+#include "anneal.h"
+
+/**
+* Starts from roughly square rows: each row is its modules joined with V,
+* and the rows are stacked with H.
+*/
+SlicingFloorplan::SlicingFloorplan(const std::vector<Rectangle>& pieces, int outlineWidth, int outlineHeight) :
+    pieces_(pieces), root_(-1), bestPoint_(0), lastMove_(NONE), lastA_(0), lastB_(0),
+    moduleArea_(0), outlineWidth_(outlineWidth), outlineHeight_(outlineHeight)
+{
+    int count = pieces_.size();
+    int total = count > 0 ? 2 * count - 1 : 0;
+    type_.assign(total, LEAF);
+    int perRow = std::max(1, (int)std::sqrt((double)count));
+    int nextOperator = count;
+    for (int i = 0; i < count; i++)
+    {
+        moduleArea_ += (long long)pieces_[i].length * pieces_[i].height;
+        expr_.push_back(i);
+        if(i % perRow != 0)
+        {
+            type_[nextOperator] = V;
+            expr_.push_back(nextOperator++);
+        }
+        //close a finished row (other than the first) onto the ones below it
+        if((i % perRow == perRow - 1 || i == count - 1) && i >= perRow)
+        {
+            type_[nextOperator] = H;
+            expr_.push_back(nextOperator++);
+        }
+    }
+    build();
+    keepBest();
+}
+
+int SlicingFloorplan::size() const
+{
+    return pieces_.size();
+}
+
+double SlicingFloorplan::cost() const
+{
+    return packingCost(getWidth(), getHeight(), moduleArea_, outlineWidth_, outlineHeight_);
+}
+
+int SlicingFloorplan::getWidth() const
+{
+    return root_ < 0 ? 0 : curve_[root_][bestPoint_].width;
+}
+
+int SlicingFloorplan::getHeight() const
+{
+    return root_ < 0 ? 0 : curve_[root_][bestPoint_].height;
+}
+
+/**
+* Rebuilds the slicing tree, stack depths and every shape curve from the
+* expression. Only used at start-up and when restoring the best floorplan.
+*/
+void SlicingFloorplan::build()
+{
+    int total = expr_.size();
+    position_.assign(total, 0);
+    depth_.assign(total, 0);
+    left_.assign(total, -1);
+    right_.assign(total, -1);
+    parent_.assign(total, -1);
+    curve_.assign(total, std::vector<ShapePoint>());
+    std::vector<int> stack;
+    for (int pos = 0; pos < total; pos++)
+    {
+        int node = expr_[pos];
+        position_[node] = pos;
+        if(type_[node] == LEAF)
+        {
+            const Rectangle& r = pieces_[node];
+            ShapePoint upright = {r.length, r.height, 0, 0};
+            ShapePoint turned = {r.height, r.length, 1, 0};
+            if(r.length < r.height)
+            {
+                curve_[node].push_back(upright);
+                curve_[node].push_back(turned);
+            }
+            else if(r.length > r.height)
+            {
+                curve_[node].push_back(turned);
+                curve_[node].push_back(upright);
+            }
+            else
+            {
+                curve_[node].push_back(upright);
+            }
+        }
+        else
+        {
+            int second = stack.back();
+            stack.pop_back();
+            int first = stack.back();
+            stack.pop_back();
+            setChild(node, true, first);
+            setChild(node, false, second);
+            combine(node);
+        }
+        stack.push_back(node);
+        depth_[pos] = stack.size();
+    }
+    root_ = stack.empty() ? -1 : stack.back();
+    if(root_ >= 0)
+    {
+        parent_[root_] = -1;
+        pickBest();
+    }
+}
+
+void SlicingFloorplan::setChild(int parent, bool left, int child)
+{
+    if(left)
+    {
+        left_[parent] = child;
+    }
+    else
+    {
+        right_[parent] = child;
+    }
+    parent_[child] = parent;
+}
+
+/**
+* Stockmeyer's merge of the children's curves, both sorted by width with
+* heights falling. For V the widths add and the taller side sets the
+* height, so the walk always advances the taller side. H is the same with
+* width and height exchanged, walked from the wide end. Either way it is
+* linear in the curve sizes.
+*/
+void SlicingFloorplan::combine(int node)
+{
+    const std::vector<ShapePoint>& a = curve_[left_[node]];
+    const std::vector<ShapePoint>& b = curve_[right_[node]];
+    std::vector<ShapePoint>& out = curve_[node];
+    out.clear();
+    if(type_[node] == V)
+    {
+        size_t i = 0;
+        size_t j = 0;
+        while(true)
+        {
+            ShapePoint p = {a[i].width + b[j].width, std::max(a[i].height, b[j].height), (int)i, (int)j};
+            if(!out.empty() && out.back().height <= p.height)
+            {
+                //dominated by the narrower point before it
+            }
+            else
+            {
+                out.push_back(p);
+            }
+            //only lowering the taller side can lower the height
+            bool moveA = a[i].height >= b[j].height;
+            bool moveB = b[j].height >= a[i].height;
+            if((moveA && i + 1 >= a.size()) || (moveB && j + 1 >= b.size()))
+            {
+                break;
+            }
+            if(moveA)
+            {
+                i++;
+            }
+            if(moveB)
+            {
+                j++;
+            }
+        }
+    }
+    else
+    {
+        int i = a.size() - 1;
+        int j = b.size() - 1;
+        while(true)
+        {
+            ShapePoint p = {std::max(a[i].width, b[j].width), a[i].height + b[j].height, i, j};
+            if(!out.empty() && out.back().width <= p.width)
+            {
+                //dominated by the shorter point before it
+            }
+            else
+            {
+                out.push_back(p);
+            }
+            //only narrowing the wider side can narrow the stack
+            bool moveA = a[i].width >= b[j].width;
+            bool moveB = b[j].width >= a[i].width;
+            if((moveA && i == 0) || (moveB && j == 0))
+            {
+                break;
+            }
+            if(moveA)
+            {
+                i--;
+            }
+            if(moveB)
+            {
+                j--;
+            }
+        }
+        std::reverse(out.begin(), out.end());
+    }
+}
+
+// Re-merges the curves from node up to the root
+void SlicingFloorplan::refresh(int node)
+{
+    while(node >= 0)
+    {
+        if(type_[node] != LEAF)
+        {
+            combine(node);
+        }
+        node = parent_[node];
+    }
+}
+
+void SlicingFloorplan::pickBest()
+{
+    const std::vector<ShapePoint>& top = curve_[root_];
+    bestPoint_ = 0;
+    double best = 0;
+    for (size_t k = 0; k < top.size(); k++)
+    {
+        double c = packingCost(top[k].width, top[k].height, moduleArea_, outlineWidth_, outlineHeight_);
+        if(k == 0 || c < best)
+        {
+            best = c;
+            bestPoint_ = k;
+        }
+    }
+}
+
+int SlicingFloorplan::nextOperand(int pos) const
+{
+    for (int p = pos + 1; p < (int)expr_.size(); p++)
+    {
+        if(type_[expr_[p]] == LEAF)
+        {
+            return p;
+        }
+    }
+    return -1;
+}
+
+/**
+* M1: the two leaves trade places in the tree; only their two root paths
+* change.
+*/
+bool SlicingFloorplan::swapOperands(int first, int second)
+{
+    int a = expr_[first];
+    int b = expr_[second];
+    int pa = parent_[a];
+    int pb = parent_[b];
+    if(pa == pb)
+    {
+        std::swap(left_[pa], right_[pa]);
+    }
+    else
+    {
+        bool aLeft = left_[pa] == a;
+        bool bLeft = left_[pb] == b;
+        setChild(pa, aLeft, b);
+        setChild(pb, bLeft, a);
+    }
+    std::swap(expr_[first], expr_[second]);
+    position_[a] = second;
+    position_[b] = first;
+    refresh(pa);
+    if(pb != pa)
+    {
+        refresh(pb);
+    }
+    pickBest();
+    return true;
+}
+
+/**
+* M2: a run of consecutive operators is a path in the tree (each one's
+* right child is the one before it), so refreshing from its first
+* operator covers everything that changed.
+*/
+void SlicingFloorplan::complementChain(int from, int to)
+{
+    for (int pos = from; pos <= to; pos++)
+    {
+        char& t = type_[expr_[pos]];
+        t = t == V ? (char)H : (char)V;
+    }
+    refresh(expr_[from]);
+    pickBest();
+}
+
+/**
+* M3: swaps the operand and operator at pos and pos+1, relinking only the
+* handful of nodes whose stack slots change. Refuses (returning false) if
+* the result would not be a normalized Polish expression.
+*/
+bool SlicingFloorplan::swapOperator(int pos)
+{
+    if(pos < 0 || pos + 1 >= (int)expr_.size())
+    {
+        return false;
+    }
+    int first = expr_[pos];
+    int second = expr_[pos + 1];
+    if(type_[first] == LEAF && type_[second] != LEAF)
+    {
+        //"A o" -> "o A": o needs two subtrees below A, and must not repeat
+        //the operator in front of it
+        int op = second;
+        if(pos == 0 || depth_[pos - 1] < 2 || type_[expr_[pos - 1]] == type_[op])
+        {
+            return false;
+        }
+        int a = first;
+        int l = expr_[pos - 1];
+        //the subtree under L on the stack is the left child of the first
+        //ancestor of o that is reached from its right
+        int c = op;
+        while(left_[parent_[c]] == c)
+        {
+            c = parent_[c];
+        }
+        int q = parent_[c];
+        int under = left_[q];
+        int p = parent_[op];
+        bool opLeft = left_[p] == op;
+        setChild(q, true, op);
+        setChild(p, opLeft, a);
+        setChild(op, true, under);
+        setChild(op, false, l);
+        expr_[pos] = op;
+        expr_[pos + 1] = a;
+        position_[op] = pos;
+        position_[a] = pos + 1;
+        depth_[pos] = depth_[pos - 1] - 1;
+        refresh(op);
+        refresh(parent_[a]);
+    }
+    else if(type_[first] != LEAF && type_[second] == LEAF)
+    {
+        //"o A" -> "A o": o must not repeat the operator after A
+        int op = first;
+        if(pos + 2 < (int)expr_.size() && type_[expr_[pos + 2]] == type_[op])
+        {
+            return false;
+        }
+        int a = second;
+        int x = left_[op];
+        int y = right_[op];
+        int pOp = parent_[op];
+        bool opLeft = left_[pOp] == op;
+        int pA = parent_[a];
+        bool aLeft = left_[pA] == a;
+        setChild(pOp, opLeft, x);
+        setChild(pA, aLeft, op);
+        setChild(op, true, y);
+        setChild(op, false, a);
+        expr_[pos] = a;
+        expr_[pos + 1] = op;
+        position_[a] = pos;
+        position_[op] = pos + 1;
+        depth_[pos] = depth_[pos - 1] + 1;
+        refresh(op);
+        refresh(parent_[x]);
+    }
+    else
+    {
+        return false;
+    }
+    pickBest();
+    return true;
+}
+
+void SlicingFloorplan::perturb(std::mt19937& rng)
+{
+    lastMove_ = NONE;
+    int total = expr_.size();
+    if(size() < 2)
+    {
+        return;
+    }
+    for (int tries = 0; tries < 10 && lastMove_ == NONE; tries++)
+    {
+        int kind = rng() % 3;
+        if(kind == 0)
+        {
+            int p = position_[rng() % size()];
+            int q = nextOperand(p);
+            if(q >= 0)
+            {
+                swapOperands(p, q);
+                lastMove_ = SWAP_OPERANDS;
+                lastA_ = p;
+                lastB_ = q;
+            }
+        }
+        else if(kind == 1)
+        {
+            int pos = rng() % total;
+            if(type_[expr_[pos]] != LEAF)
+            {
+                int from = pos;
+                int to = pos;
+                while(from > 0 && type_[expr_[from - 1]] != LEAF)
+                {
+                    from--;
+                }
+                while(to + 1 < total && type_[expr_[to + 1]] != LEAF)
+                {
+                    to++;
+                }
+                complementChain(from, to);
+                lastMove_ = COMPLEMENT_CHAIN;
+                lastA_ = from;
+                lastB_ = to;
+            }
+        }
+        else
+        {
+            int pos = rng() % (total - 1);
+            if(swapOperator(pos))
+            {
+                lastMove_ = SWAP_OPERATOR;
+                lastA_ = pos;
+            }
+        }
+    }
+}
+
+// Every move is undone by applying it again at the same place
+void SlicingFloorplan::undo()
+{
+    if(lastMove_ == SWAP_OPERANDS)
+    {
+        swapOperands(lastA_, lastB_);
+    }
+    else if(lastMove_ == COMPLEMENT_CHAIN)
+    {
+        complementChain(lastA_, lastB_);
+    }
+    else if(lastMove_ == SWAP_OPERATOR)
+    {
+        swapOperator(lastA_);
+    }
+    lastMove_ = NONE;
+}
+
+void SlicingFloorplan::keepBest()
+{
+    bestExpr_ = expr_;
+    bestType_ = type_;
+}
+
+void SlicingFloorplan::restoreBest()
+{
+    expr_ = bestExpr_;
+    type_ = bestType_;
+    build();
+}
+
+/**
+* Walks down from the cheapest root shape, handing every child the curve
+* point that produced its parent's.
+*/
+void SlicingFloorplan::placements(std::vector<Placement>& placed)
+{
+    placed.clear();
+    if(root_ < 0)
+    {
+        return;
+    }
+    struct Visit
+    {
+        int node;
+        int point;
+        int x;
+        int y;
+    };
+    std::vector<Visit> stack;
+    Visit start = {root_, bestPoint_, 0, 0};
+    stack.push_back(start);
+    while(!stack.empty())
+    {
+        Visit v = stack.back();
+        stack.pop_back();
+        const ShapePoint& p = curve_[v.node][v.point];
+        if(type_[v.node] == LEAF)
+        {
+            Placement piece = {pieces_[v.node].ID, v.x, v.y, p.width, p.height};
+            placed.push_back(piece);
+            continue;
+        }
+        const ShapePoint& lp = curve_[left_[v.node]][p.left];
+        Visit l = {left_[v.node], p.left, v.x, v.y};
+        Visit r = {right_[v.node], p.right, v.x, v.y};
+        if(type_[v.node] == V)
+        {
+            r.x += lp.width;
+        }
+        else
+        {
+            r.y += lp.height;
+        }
+        stack.push_back(l);
+        stack.push_back(r);
+    }
+}
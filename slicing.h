@@ -0,0 +1,95 @@
+#ifndef SLICING_H
+#define SLICING_H
+
+#include <vector>
+#include <random>
+#include "floorplan.h"
+
+/**
+* A slicing floorplan written as a normalized Polish expression (Wong-Liu):
+* a postfix expression over the modules with the cut operators V (left and
+* right child side by side) and H (left child below the right child), never
+* two equal operators in a row.
+*
+* Every node of the slicing tree keeps its shape curve, the non-dominated
+* (width, height) pairs its subtree can take, built with Stockmeyer's merge;
+* leaves offer both orientations. A move only touches a few nodes and
+* re-merges the curves on their paths to the root, so it costs O(depth)
+* merges instead of re-evaluating the whole tree. The moves are M1 (swap
+* two neighbouring operands), M2 (complement a chain of operators) and M3
+* (swap a neighbouring operand and operator, kept only if the result is
+* still a normalized expression). It satisfies the Plan interface of
+* anneal().
+*/
+class SlicingFloorplan
+{
+public:
+    // An outline of 0 x 0 means minimise area with no fixed outline
+    SlicingFloorplan(const std::vector<Rectangle>& pieces, int outlineWidth, int outlineHeight);
+
+    int size() const;
+    double cost() const;
+    void perturb(std::mt19937& rng);
+    void undo();
+    void keepBest();
+    void restoreBest();
+
+    // Bounding box of the cheapest shape of the current floorplan
+    int getWidth() const;
+    int getHeight() const;
+
+    // Coordinates of every module in the cheapest shape
+    void placements(std::vector<Placement>& placed);
+
+private:
+    // A point on a shape curve, with the child points that produce it
+    struct ShapePoint
+    {
+        int width;
+        int height;
+        int left;
+        int right;
+    };
+
+    enum Move { NONE, SWAP_OPERANDS, COMPLEMENT_CHAIN, SWAP_OPERATOR };
+
+    enum NodeType { LEAF = 0, V = 'V', H = 'H' };
+
+    void build();
+    void combine(int node);
+    void refresh(int node);
+    void pickBest();
+    void setChild(int parent, bool left, int child);
+    bool swapOperands(int first, int second);
+    void complementChain(int from, int to);
+    bool swapOperator(int pos);
+    int nextOperand(int pos) const;
+
+    std::vector<Rectangle> pieces_;
+    // the expression as node ids; ids below size() are modules
+    std::vector<int> expr_;
+    // stack depth after each token of the expression
+    std::vector<int> depth_;
+    std::vector<int> position_;
+    std::vector<char> type_;
+    std::vector<int> left_;
+    std::vector<int> right_;
+    std::vector<int> parent_;
+    std::vector<std::vector<ShapePoint> > curve_;
+    int root_;
+    // index of the cheapest point on the root's curve
+    int bestPoint_;
+
+    Move lastMove_;
+    int lastA_;
+    int lastB_;
+
+    std::vector<int> bestExpr_;
+    std::vector<char> bestType_;
+
+    long long moduleArea_;
+    int outlineWidth_;
+    int outlineHeight_;
+};
+
+#endif
@@ -0,0 +1,1916 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <random>
+#include <set>
+#include <atomic>
+#include <unordered_set>
+#include <thread>
+#include "floorplan.h"
+
+// Everything in this file but the FloorplanSolver API is private to it, so
+// the helpers' plain names cannot clash with a program linking the library
+namespace
+{
+
+// Dummy operator << for pairs and Rectangles so the BST and AVL BST will
+// compile with their printRoot() implementations. They have to be
+// declared before the tree headers so that their templates can see them.
+template <typename T, typename U>
+std::ostream& operator<<(std::ostream& os, const std::pair<T,U>& p)
+{
+    os << p.first << "," << p.second;
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const Rectangle& r)
+{
+    os << r.ID;
+    return os;
+}
+
+}
+
+#include "avlbst.h"
+#include "quadtree.h"
+#include "bitboard.h"
+#include "fixedboard.h"
+#include "solver.h"
+#include "skyline.h"
+#include "anneal.h"
+#include "btree.h"
+#include "seqpair.h"
+#include "slicing.h"
+
+using namespace std;
+
+namespace
+{
+
+// Typedefs for you input and output map. Start with
+// std::map but once the backtracking search algorithm is working
+// try to use your AVL-tree map implementation by changing these
+// typedef's
+typedef AVLTree<int, Rectangle> InputMapType;
+typedef AVLTree<int, std::pair<int, int> > OutputMapType;
+
+// The sequence in which search() places the pieces
+typedef std::vector<InputMapType::iterator> PieceOrder;
+
+// Budget and bookkeeping for the anytime mode of search(). A limit of 0
+// means unlimited. The placements along the branch being explored are kept
+// in current, and whenever that branch covers more area than anything seen
+// before it is copied into best.
+struct SearchState
+{
+    SearchState();
+    bool outOfBudget();
+    bool scanOutOfBudget();
+    void push(const Placement& p);
+    void pop();
+
+    // size of the board being searched
+    int width;
+    int height;
+    long long nodeLimit;
+    long long timeLimitMs;
+    std::chrono::steady_clock::time_point start;
+    long long nodes;
+    // positions tried by search(), for scanOutOfBudget()
+    long long probes;
+    bool exhausted;
+    std::vector<Placement> current;
+    long long currentArea;
+    std::vector<Placement> best;
+    long long bestArea;
+    // order in which search() tries the x and y coordinates, identity if
+    // left empty
+    std::vector<int> xOrder;
+    std::vector<int> yOrder;
+    // set by another thread to stop the search early, if not NULL
+    const std::atomic<bool>* cancel;
+    // nogood learning: boardHash covers the occupied cells and piecesHash
+    // the multiset of pieces still to place; a combination that failed is
+    // kept in nogoods
+    bool learning;
+    unsigned long long boardHash;
+    unsigned long long piecesHash;
+    std::unordered_set<unsigned long long> nogoods;
+    // split the free space into independent regions (flat grid only)
+    bool decomposing;
+};
+
+SearchState::SearchState() :
+    width(0), height(0), nodeLimit(0), timeLimitMs(0), start(std::chrono::steady_clock::now()),
+    nodes(0), probes(0), exhausted(false), currentArea(0), bestArea(0), cancel(NULL),
+    learning(false), boardHash(0), piecesHash(0), decomposing(false)
+{
+
+}
+
+// Counts one search node and reports whether the budget has run out. The
+// clock is only read every 1024 nodes to keep the check cheap.
+bool SearchState::outOfBudget()
+{
+    if(exhausted)
+    {
+        return true;
+    }
+    nodes++;
+    if(nodeLimit > 0 && nodes > nodeLimit)
+    {
+        exhausted = true;
+    }
+    else if(cancel != NULL && cancel->load(std::memory_order_relaxed))
+    {
+        exhausted = true;
+    }
+    else if(timeLimitMs > 0 && (nodes & 1023) == 0)
+    {
+        long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if(elapsed >= timeLimitMs)
+        {
+            exhausted = true;
+        }
+    }
+    return exhausted;
+}
+
+// Positions a node tries between readings of the clock. One node can try
+// every cell of the board, so on large boards the check between nodes
+// alone would overrun the time limit by seconds.
+const long long PROBE_CHECK_INTERVAL = 4096;
+
+// Counts one position tried within a node and, every PROBE_CHECK_INTERVAL
+// of them, reports whether the time limit has passed or the search was
+// cancelled
+bool SearchState::scanOutOfBudget()
+{
+    if(exhausted)
+    {
+        return true;
+    }
+    if((++probes & (PROBE_CHECK_INTERVAL - 1)) != 0)
+    {
+        return false;
+    }
+    if(cancel != NULL && cancel->load(std::memory_order_relaxed))
+    {
+        exhausted = true;
+    }
+    else if(timeLimitMs > 0 && std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - start).count() >= timeLimitMs)
+    {
+        exhausted = true;
+    }
+    return exhausted;
+}
+
+void SearchState::push(const Placement& p)
+{
+    current.push_back(p);
+    currentArea += (long long)p.length * p.height;
+    if(currentArea > bestArea)
+    {
+        best = current;
+        bestArea = currentArea;
+    }
+}
+
+void SearchState::pop()
+{
+    currentArea -= (long long)current.back().length * current.back().height;
+    current.pop_back();
+}
+
+// Learning stops recording nogoods once this many are stored
+const size_t NOGOOD_LIMIT = 1 << 18;
+
+// splitmix64 finaliser, used to give every cell and piece shape a
+// pseudo-random 64-bit key
+unsigned long long mixHash(unsigned long long x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Key of a piece shape, the same in both orientations. A multiset of pieces
+// hashes to the sum of their keys.
+unsigned long long shapeHash(const Rectangle& r)
+{
+    unsigned long long shortSide = min(r.length, r.height);
+    unsigned long long longSide = max(r.length, r.height);
+    return mixHash((shortSide << 32) | longSide);
+}
+
+// XOR of the keys of the cells under a rectangle; XOR-ing it into a board
+// hash toggles those cells the same way flip() does
+unsigned long long cellsHash(int x1, int y1, const Rectangle& r, int height)
+{
+    unsigned long long h = 0;
+    for (int x = x1; x < x1 + r.length; x++)
+    {
+        for (int y = y1; y < y1 + r.height; y++)
+        {
+            h ^= mixHash((unsigned long long)x * height + y);
+        }
+    }
+    return h;
+}
+
+// Boards with more cells than this are not split into free regions; the
+// flood fill at every node would cost more than it saves
+const long long DECOMPOSE_MAX_CELLS = 1 << 12;
+
+// Boards with more cells than this are tracked with a QuadTree instead of
+// a flat grid
+const long long QUADTREE_MIN_CELLS = 1LL << 20;
+
+bool placementLarger(const Placement& a, const Placement& b)
+{
+    return (long long)a.length * a.height > (long long)b.length * b.height;
+}
+
+// Changes the grid entries to their opposite values for the
+// rectangle r starting at x1,y1
+void flip(int x1, int y1, const Rectangle& r, BitBoard& grid)
+{
+    grid.flip(x1, y1, r.length, r.height);
+}
+
+//check if rectangle is within bounds of grid and if spaces on grid are already occupied or not
+bool gridcheck(int row, int col, InputMapType::iterator it, const BitBoard& grid)
+{
+    //check if rectangle is within bounds of board
+    if(it->second.length + row > grid.getWidth() || it->second.height + col > grid.getHeight())
+    {
+        return false;
+    }
+    return grid.isEmpty(row, col, it->second.length, it->second.height);
+}
+
+//fixed-size board versions of flip and gridcheck
+template <int Words>
+void flip(int x1, int y1, const Rectangle& r, FixedBoard<Words>& grid)
+{
+    grid.flip(x1, y1, r.length, r.height);
+}
+
+template <int Words>
+bool gridcheck(int row, int col, InputMapType::iterator it, const FixedBoard<Words>& grid)
+{
+    if(it->second.length + row > grid.getWidth() || it->second.height + col > grid.getHeight())
+    {
+        return false;
+    }
+    return grid.isEmpty(row, col, it->second.length, it->second.height);
+}
+
+// Toggles the rectangle r starting at x1,y1 on a quadtree board. search()
+// only flips a rectangle that is either completely free or that it placed
+// itself, so looking at one corner tells us which way to go.
+void flip(int x1, int y1, const Rectangle& r, QuadTree& grid)
+{
+    if(grid.get(x1, y1))
+    {
+        grid.clear(x1, y1, r.length, r.height);
+    }
+    else
+    {
+        grid.fill(x1, y1, r.length, r.height);
+    }
+}
+
+//quadtree version of gridcheck
+bool gridcheck(int row, int col, InputMapType::iterator it, const QuadTree& grid)
+{
+    if(it->second.length + row > grid.getWidth() || it->second.height + col > grid.getHeight())
+    {
+        return false;
+    }
+    return grid.isEmpty(row, col, it->second.length, it->second.height);
+}
+
+bool pieceLarger(InputMapType::iterator a, InputMapType::iterator b)
+{
+    return (long long)a->second.length * a->second.height > (long long)b->second.length * b->second.height;
+}
+
+// A 4-connected area of free cells and its bounding box
+struct FreeRegion
+{
+    int area;
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+};
+
+template <typename GridType>
+int decompose(PieceOrder::const_iterator it, GridType& grid, PieceOrder::const_iterator end,
+              OutputMapType& answer, SearchState& state);
+
+// Quadtree boards are too large to flood fill
+int decompose(PieceOrder::const_iterator it, QuadTree& grid, PieceOrder::const_iterator end,
+              OutputMapType& answer, SearchState& state)
+{
+    return -1;
+}
+
+// Backtracking search. GridType is any board representation with
+// matching gridcheck() and flip() overloads. The board is shared by
+// reference: every placement is undone with flip() before trying the next.
+// Gives up (returning false with state.exhausted set) once the budget in
+// state runs out.
+// Pieces are placed in the sequence given by the iterators over a PieceOrder.
+template <typename GridType>
+bool search(PieceOrder::const_iterator it, GridType& grid, PieceOrder::const_iterator end, OutputMapType &answer,
+            SearchState& state)
+{
+    if(it == end)
+    {
+        return true;
+    }
+    else if(state.outOfBudget())
+    {
+        return false;
+    }
+    else if(state.learning && state.nogoods.count(state.boardHash ^ mixHash(state.piecesHash)))
+    {
+        //the same free cells have already failed to take the same pieces
+        return false;
+    }
+    else
+    {
+        int split = decompose(it, grid, end, answer, state);
+        if(split == 1)
+        {
+            return true;
+        }
+        else if(split == 0)
+        {
+            if(state.learning && !state.exhausted && state.nogoods.size() < NOGOOD_LIMIT)
+            {
+                state.nogoods.insert(state.boardHash ^ mixHash(state.piecesHash));
+            }
+            return false;
+        }
+        InputMapType::iterator piece = *it;
+        unsigned long long shape = shapeHash(piece->second);
+        state.piecesHash -= shape;
+        for(int a = 0; a < state.width; a++)
+        {
+            int i = state.xOrder[a];
+            for(int b = 0; b < state.height; b++)
+            {
+                int j = state.yOrder[b];
+                if(state.scanOutOfBudget())
+                {
+                    state.piecesHash += shape;
+                    return false;
+                }
+                if(gridcheck(i,j,piece, grid))
+                {
+                    flip(i, j, piece->second, grid);
+                    unsigned long long cells = state.learning ? cellsHash(i, j, piece->second, state.height) : 0;
+                    state.boardHash ^= cells;
+                    Placement placed = {piece->first, i, j, piece->second.length, piece->second.height};
+                    state.push(placed);
+                    //create a temp iterator so that we don't change the original iterator passed in
+                    //to the function in case we return
+                    PieceOrder::const_iterator temp = it;
+                    if(search(++temp, grid, end, answer, state))
+                    {
+                        //succesfully placed the rectangle onto board, so insert into OutputMap
+                        pair<int, std::pair<int, int>> rect = make_pair(piece->first, std::make_pair(i,j));
+                        answer.insert(rect);
+                        state.piecesHash += shape;
+                        return true;
+                    }
+                    //unsuccessful in trying to fit rectangle onto current board state
+                    else
+                    {
+                        state.pop();
+                        flip(i,j, piece->second,grid);
+                        state.boardHash ^= cells;
+                        if(state.exhausted)
+                        {
+                            state.piecesHash += shape;
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        //rotate the rectangle by switching its lenght and height and try everything again
+        int temp = piece->second.height;
+        piece->second.height = piece->second.length;
+        piece->second.length = temp;
+        for(int a = 0; a < state.width; a++)
+        {
+            int i = state.xOrder[a];
+            for(int b = 0; b < state.height; b++)
+            {
+                int j = state.yOrder[b];
+                if(state.scanOutOfBudget())
+                {
+                    state.piecesHash += shape;
+                    return false;
+                }
+                if(gridcheck(i,j, piece, grid))
+                {
+                    flip(i, j, piece->second, grid);
+                    unsigned long long cells = state.learning ? cellsHash(i, j, piece->second, state.height) : 0;
+                    state.boardHash ^= cells;
+                    Placement placed = {piece->first, i, j, piece->second.length, piece->second.height};
+                    state.push(placed);
+                    PieceOrder::const_iterator temp = it;
+                    if(search(++temp, grid, end, answer, state))
+                    {
+                        pair<int, std::pair<int, int>> rect = make_pair(piece->first, std::make_pair(i,j));
+                        answer.insert(rect);
+                        state.piecesHash += shape;
+                        return true;
+                    }
+                    else
+                    {
+                        state.pop();
+                        flip(i,j, piece->second,grid);
+                        state.boardHash ^= cells;
+                        if(state.exhausted)
+                        {
+                            state.piecesHash += shape;
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        state.piecesHash += shape;
+        if(state.learning && state.nogoods.size() < NOGOOD_LIMIT)
+        {
+            state.nogoods.insert(state.boardHash ^ mixHash(state.piecesHash));
+        }
+    }
+    return false;
+}
+// Labels every free cell with the index of its 4-connected region (label is
+// indexed x * m + y, -1 for taken cells) and describes the regions
+template <typename GridType>
+void freeRegions(const GridType& grid, vector<int>& label, vector<FreeRegion>& regions)
+{
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    label.assign((size_t)width * height, -1);
+    regions.clear();
+    vector<pair<int, int> > stack;
+    for (int x = 0; x < width; x++)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            if(grid.get(x, y) || label[x * height + y] >= 0)
+            {
+                continue;
+            }
+            FreeRegion region = {0, x, y, x, y};
+            int id = regions.size();
+            label[x * height + y] = id;
+            stack.push_back(make_pair(x, y));
+            while(!stack.empty())
+            {
+                int cx = stack.back().first;
+                int cy = stack.back().second;
+                stack.pop_back();
+                region.area++;
+                region.minX = min(region.minX, cx);
+                region.minY = min(region.minY, cy);
+                region.maxX = max(region.maxX, cx);
+                region.maxY = max(region.maxY, cy);
+                const int dx[4] = {1, -1, 0, 0};
+                const int dy[4] = {0, 0, 1, -1};
+                for (int d = 0; d < 4; d++)
+                {
+                    int nx = cx + dx[d];
+                    int ny = cy + dy[d];
+                    if(nx >= 0 && nx < width && ny >= 0 && ny < height && !grid.get(nx, ny) && label[nx * height + ny] < 0)
+                    {
+                        label[nx * height + ny] = id;
+                        stack.push_back(make_pair(nx, ny));
+                    }
+                }
+            }
+            regions.push_back(region);
+        }
+    }
+}
+
+// Fixed-size boards grow each region as a mask and only then visit its cells
+template <int Words>
+void freeRegions(const FixedBoard<Words>& grid, vector<int>& label, vector<FreeRegion>& regions)
+{
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    label.assign((size_t)width * height, -1);
+    regions.clear();
+    uint64_t free[Words];
+    grid.freeCells(free);
+    while(true)
+    {
+        bool any = false;
+        for (int k = 0; k < Words; k++)
+        {
+            any = any || free[k] != 0;
+        }
+        if(!any)
+        {
+            break;
+        }
+        uint64_t region[Words];
+        grid.regionOf(free, region);
+        FreeRegion found = {0, width, height, -1, -1};
+        int id = regions.size();
+        for (int k = 0; k < Words; k++)
+        {
+            free[k] &= ~region[k];
+            for (uint64_t bits = region[k]; bits != 0; bits &= bits - 1)
+            {
+                int cell = k * 64 + __builtin_ctzll(bits);
+                int x = cell / height;
+                int y = cell % height;
+                label[cell] = id;
+                found.area++;
+                found.minX = min(found.minX, x);
+                found.minY = min(found.minY, y);
+                found.maxX = max(found.maxX, x);
+                found.maxY = max(found.maxY, y);
+            }
+        }
+        regions.push_back(found);
+    }
+}
+
+// Whether a piece could go into a region at all, going by its area and
+// bounding box
+bool regionCanHold(const FreeRegion& region, const Rectangle& r)
+{
+    int w = region.maxX - region.minX + 1;
+    int h = region.maxY - region.minY + 1;
+    long long area = (long long)r.length * r.height;
+    return area <= region.area &&
+           ((r.length <= w && r.height <= h) || (r.height <= w && r.length <= h));
+}
+
+// Takes every cell that is still free outside region keep (as labelled by
+// freeRegions()), so that a search confined to keep cannot place anything
+// elsewhere. The cells taken are added to blocked for openCells().
+template <typename GridType>
+void blockOtherRegions(GridType& grid, const vector<int>& label, int keep, SearchState& state,
+                       vector<int>& blocked)
+{
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    for (int x = 0; x < width; x++)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            int id = label[x * height + y];
+            if(id >= 0 && id != keep && !grid.get(x, y))
+            {
+                grid.toggle(x, y);
+                blocked.push_back(x * height + y);
+            }
+        }
+    }
+    if(state.learning)
+    {
+        for (size_t i = 0; i < blocked.size(); i++)
+        {
+            state.boardHash ^= mixHash(blocked[i]);
+        }
+    }
+}
+
+// Frees the cells blockOtherRegions() took
+template <typename GridType>
+void openCells(GridType& grid, const vector<int>& blocked, SearchState& state)
+{
+    for (size_t i = 0; i < blocked.size(); i++)
+    {
+        grid.toggle(blocked[i] / grid.getHeight(), blocked[i] % grid.getHeight());
+        if(state.learning)
+        {
+            state.boardHash ^= mixHash(blocked[i]);
+        }
+    }
+}
+
+// Takes the last count placements in state.current back off the board
+template <typename GridType>
+void unplace(GridType& grid, SearchState& state, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const Placement& p = state.current.back();
+        Rectangle r = {p.ID, p.length, p.height};
+        flip(p.x, p.y, r, grid);
+        if(state.learning)
+        {
+            state.boardHash ^= cellsHash(p.x, p.y, r, state.height);
+        }
+        state.pop();
+    }
+}
+
+// Solves every region on its own with the pieces assigned to it, one region
+// at a time with the rest of the board blocked off. Either all of them
+// succeed, leaving their pieces on the board and in answer, or the board and
+// state are left as they were.
+template <typename GridType>
+bool solveRegions(const PieceOrder& pieces, const vector<int>& assigned, const vector<int>& live,
+                  GridType& grid, const vector<int>& label, OutputMapType& answer,
+                  SearchState& state)
+{
+    unsigned long long piecesHash = state.piecesHash;
+    size_t placed = 0;
+    OutputMapType parts;
+    bool solved = true;
+    for (size_t r = 0; r < live.size() && solved; r++)
+    {
+        PieceOrder sub;
+        state.piecesHash = 0;
+        for (size_t k = 0; k < pieces.size(); k++)
+        {
+            if(assigned[k] == (int)r)
+            {
+                sub.push_back(pieces[k]);
+                state.piecesHash += shapeHash(pieces[k]->second);
+            }
+        }
+        if(sub.empty())
+        {
+            continue;
+        }
+        vector<int> blocked;
+        blockOtherRegions(grid, label, live[r], state, blocked);
+        solved = search(sub.begin(), grid, sub.end(), parts, state);
+        openCells(grid, blocked, state);
+        if(solved)
+        {
+            placed += sub.size();
+        }
+    }
+    state.piecesHash = piecesHash;
+    if(!solved)
+    {
+        unplace(grid, state, placed);
+        return false;
+    }
+    for (OutputMapType::iterator pit = parts.begin(); pit != parts.end(); ++pit)
+    {
+        answer.insert(make_pair(pit->first, pit->second));
+    }
+    return true;
+}
+
+// Hands the pieces from index k on to the live regions, largest pieces
+// first, without going over any region's free area, and tries to solve each
+// complete assignment. Returns 1 on success, 0 when no assignment works.
+template <typename GridType>
+int assignPieces(size_t k, const PieceOrder& pieces, vector<int>& assigned, vector<long long>& room,
+                 const vector<int>& live, const vector<FreeRegion>& regions, GridType& grid,
+                 const vector<int>& label, OutputMapType& answer, SearchState& state)
+{
+    if(k == pieces.size())
+    {
+        return solveRegions(pieces, assigned, live, grid, label, answer, state) ? 1 : 0;
+    }
+    const Rectangle& r = pieces[k]->second;
+    long long area = (long long)r.length * r.height;
+    for (size_t i = 0; i < live.size(); i++)
+    {
+        if(room[i] < area || !regionCanHold(regions[live[i]], r))
+        {
+            continue;
+        }
+        assigned[k] = i;
+        room[i] -= area;
+        int result = assignPieces(k + 1, pieces, assigned, room, live, regions, grid, label, answer, state);
+        room[i] += area;
+        if(result == 1 || state.exhausted)
+        {
+            return result;
+        }
+    }
+    return 0;
+}
+
+/**
+* Once the pieces already placed cut the free space into several regions,
+* the pieces left form independent subproblems, one per region. Regions too
+* small to take any remaining piece are written off; if what is left cannot
+* hold the pieces, or some piece fits nowhere, the node fails outright. With
+* two or more usable regions the pieces are distributed over them as in bin
+* packing and each region is searched on its own, so k regions cost roughly
+* the sum rather than the product of their searches.
+* Returns 1 if the pieces from it to end were all placed, 0 if they cannot
+* be, and -1 if the free space is a single region and search() should carry
+* on as usual.
+*/
+template <typename GridType>
+int decompose(PieceOrder::const_iterator it, GridType& grid, PieceOrder::const_iterator end,
+              OutputMapType& answer, SearchState& state)
+{
+    if(!state.decomposing)
+    {
+        return -1;
+    }
+    vector<int> label;
+    vector<FreeRegion> regions;
+    freeRegions(grid, label, regions);
+    PieceOrder pieces(it, end);
+    vector<bool> usable(regions.size(), false);
+    long long needed = 0;
+    for (size_t k = 0; k < pieces.size(); k++)
+    {
+        bool fits = false;
+        for (size_t i = 0; i < regions.size(); i++)
+        {
+            if(regionCanHold(regions[i], pieces[k]->second))
+            {
+                usable[i] = true;
+                fits = true;
+            }
+        }
+        if(!fits)
+        {
+            return 0;
+        }
+        needed += (long long)pieces[k]->second.length * pieces[k]->second.height;
+    }
+    vector<int> live;
+    vector<long long> room;
+    long long available = 0;
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+        if(usable[i])
+        {
+            live.push_back(i);
+            room.push_back(regions[i].area);
+            available += regions[i].area;
+        }
+    }
+    if(needed > available)
+    {
+        return 0;
+    }
+    if(live.size() < 2)
+    {
+        return -1;
+    }
+    stable_sort(pieces.begin(), pieces.end(), pieceLarger);
+    vector<int> assigned(pieces.size(), -1);
+    return assignPieces(0, pieces, assigned, room, live, regions, grid, label, answer, state);
+}
+
+// Marks the cells under already placed pieces as taken
+template <typename GridType>
+void occupy(GridType& grid, const vector<Placement>& fixed)
+{
+    for (size_t i = 0; i < fixed.size(); i++)
+    {
+        Rectangle r = {fixed[i].ID, fixed[i].length, fixed[i].height};
+        flip(fixed[i].x, fixed[i].y, r, grid);
+    }
+}
+
+// Shape preparation for the bit boards; the quadtree needs none
+void prepareShape(BitBoard& grid, int length, int height)
+{
+    if(height <= grid.getHeight())
+    {
+        grid.prepare(height);
+    }
+}
+
+template <int Words>
+void prepareShape(FixedBoard<Words>& grid, int length, int height)
+{
+    grid.prepare(length, height);
+}
+
+void prepareShape(QuadTree& grid, int length, int height)
+{
+
+}
+
+// Builds the board's masks for every piece in both orientations, and for
+// the pieces already placed, before the search starts
+template <typename GridType>
+void prepareShapes(GridType& grid, const PieceOrder& order, const vector<Placement>& fixed)
+{
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        const Rectangle& r = order[i]->second;
+        prepareShape(grid, r.length, r.height);
+        prepareShape(grid, r.height, r.length);
+    }
+    for (size_t i = 0; i < fixed.size(); i++)
+    {
+        prepareShape(grid, fixed[i].length, fixed[i].height);
+    }
+}
+
+// Sets up a fresh board and searches it
+template <typename GridType>
+bool searchBoard(GridType& grid, const PieceOrder& order, const vector<Placement>& fixed, OutputMapType& output,
+                 SearchState& state)
+{
+    prepareShapes(grid, order, fixed);
+    occupy(grid, fixed);
+    return search(order.begin(), grid, order.end(), output, state);
+}
+
+// Runs search() over a state.width x state.height board on which the fixed
+// pieces are already in place, picking the board representation from the
+// size of the surface:
+// fixed-size boards up to 256 cells, a bitboard up to QUADTREE_MIN_CELLS
+// and a quadtree beyond that
+bool runSearch(const PieceOrder& order, const vector<Placement>& fixed, OutputMapType& output, SearchState& state)
+{
+    int width = state.width;
+    int height = state.height;
+    if(state.xOrder.size() != (size_t)width || state.yOrder.size() != (size_t)height)
+    {
+        state.xOrder.resize(width);
+        state.yOrder.resize(height);
+        for (int i = 0; i < width; i++)
+        {
+            state.xOrder[i] = i;
+        }
+        for (int j = 0; j < height; j++)
+        {
+            state.yOrder[j] = j;
+        }
+    }
+    //hashing the cells of every placement only pays off on the flat grid
+    state.learning = (long long)width * height <= QUADTREE_MIN_CELLS;
+    state.decomposing = (long long)width * height <= DECOMPOSE_MAX_CELLS;
+    state.boardHash = 0;
+    state.piecesHash = 0;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        state.piecesHash += shapeHash(order[i]->second);
+    }
+    long long cells = (long long)width * height;
+    //small boards get a search compiled for their size in words
+    if(cells <= 64)
+    {
+        FixedBoard<1> grid(width, height);
+        return searchBoard(grid, order, fixed, output, state);
+    }
+    else if(cells <= 128)
+    {
+        FixedBoard<2> grid(width, height);
+        return searchBoard(grid, order, fixed, output, state);
+    }
+    else if(cells <= 256)
+    {
+        FixedBoard<4> grid(width, height);
+        return searchBoard(grid, order, fixed, output, state);
+    }
+    else if(cells <= QUADTREE_MIN_CELLS)
+    {
+        BitBoard grid(width, height);
+        return searchBoard(grid, order, fixed, output, state);
+    }
+    QuadTree grid(width, height);
+    return searchBoard(grid, order, fixed, output, state);
+}
+
+bool runSearch(const PieceOrder& order, OutputMapType& output, SearchState& state)
+{
+    return runSearch(order, vector<Placement>(), output, state);
+}
+
+// Nodes in one unit of the Luby restart schedule
+const long long LUBY_UNIT = 256;
+
+// The i-th term (from 1) of the Luby sequence 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ...
+long long luby(long long i)
+{
+    long long k = 1;
+    while((1LL << k) - 1 < i)
+    {
+        k++;
+    }
+    if(i == (1LL << k) - 1)
+    {
+        return 1LL << (k - 1);
+    }
+    return luby(i - (1LL << (k - 1)) + 1);
+}
+
+// Largest pieces first, breaking ties between equal areas at random
+PieceOrder shuffledOrder(const PieceOrder& base, std::mt19937& rng)
+{
+    vector<pair<pair<long long, unsigned>, int> > keys;
+    for (size_t i = 0; i < base.size(); i++)
+    {
+        long long area = (long long)base[i]->second.length * base[i]->second.height;
+        keys.push_back(make_pair(make_pair(-area, (unsigned)rng()), (int)i));
+    }
+    sort(keys.begin(), keys.end());
+    PieceOrder order;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        order.push_back(base[keys[i].second]);
+    }
+    return order;
+}
+
+// Runs search() in short attempts whose node cutoffs follow the Luby
+// sequence (in units of LUBY_UNIT). The first attempt uses the given order
+// as is; later ones go largest first with random tie-breaking and scan the
+// board from a randomly mirrored corner. Everything is drawn from one
+// generator, so a run is reproducible from its seed as long as it is not
+// cut short by a time limit. Stops on a solution, when an attempt finishes
+// without hitting its cutoff (no solution exists), or when state's overall
+// budget runs out.
+bool restartSearch(const PieceOrder& base, OutputMapType& output, SearchState& state, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    PieceOrder order = base;
+    for (long long attempt = 1; ; attempt++)
+    {
+        SearchState run;
+        run.width = state.width;
+        run.height = state.height;
+        run.start = state.start;
+        run.timeLimitMs = state.timeLimitMs;
+        run.nodeLimit = luby(attempt) * LUBY_UNIT;
+        run.cancel = state.cancel;
+        if(state.nodeLimit > 0)
+        {
+            run.nodeLimit = min(run.nodeLimit, state.nodeLimit - state.nodes);
+        }
+        if(attempt > 1)
+        {
+            order = shuffledOrder(base, rng);
+            int width = state.width;
+            int height = state.height;
+            run.xOrder.resize(width);
+            run.yOrder.resize(height);
+            bool flipX = rng() % 2;
+            bool flipY = rng() % 2;
+            for (int i = 0; i < width; i++)
+            {
+                run.xOrder[i] = flipX ? width - 1 - i : i;
+            }
+            for (int j = 0; j < height; j++)
+            {
+                run.yOrder[j] = flipY ? height - 1 - j : j;
+            }
+        }
+        output.clear();
+        //nogoods only depend on the board and the pieces left, so every
+        //attempt can use what the earlier ones learned
+        run.nogoods.swap(state.nogoods);
+        bool found = runSearch(order, output, run);
+        run.nogoods.swap(state.nogoods);
+        state.nodes += run.nodes;
+        if(run.bestArea > state.bestArea)
+        {
+            state.best = run.best;
+            state.bestArea = run.bestArea;
+        }
+        if(found)
+        {
+            return true;
+        }
+        if(!run.exhausted)
+        {
+            return false;
+        }
+        long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - state.start).count();
+        if((state.nodeLimit > 0 && state.nodes >= state.nodeLimit) ||
+           (state.timeLimitMs > 0 && elapsed >= state.timeLimitMs) ||
+           (state.cancel != NULL && state.cancel->load(std::memory_order_relaxed)))
+        {
+            state.exhausted = true;
+            return false;
+        }
+    }
+}
+
+// The pieces in ID order
+PieceOrder idOrder(InputMapType& input)
+{
+    PieceOrder order;
+    if(input.empty())
+    {
+        return order;
+    }
+    for (InputMapType::iterator it = input.begin(); it != input.end(); ++it)
+    {
+        order.push_back(it);
+    }
+    return order;
+}
+
+// Copies the pieces out of the input map for the packing heuristics
+vector<Rectangle> pieceList(InputMapType& input)
+{
+    vector<Rectangle> pieces;
+    PieceOrder order = idOrder(input);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        pieces.push_back(order[i]->second);
+    }
+    return pieces;
+}
+
+// Order for the exact search after the skyline heuristic failed: the pieces
+// it could not place go first, the rest follow in the order it placed them
+// (largest first).
+PieceOrder seededOrder(InputMapType& input, const vector<Placement>& placed, const vector<int>& failed)
+{
+    PieceOrder order;
+    for (size_t i = 0; i < failed.size(); i++)
+    {
+        order.push_back(input.find(failed[i]));
+    }
+    for (size_t i = 0; i < placed.size(); i++)
+    {
+        order.push_back(input.find(placed[i].ID));
+    }
+    return order;
+}
+
+// Pairs each entry of a solution with the orientation its piece currently
+// has in input, so the solution survives later searches rotating pieces.
+// Both maps are ordered by ID and every placed ID is in input, so the two
+// are walked in lockstep rather than looking each piece up. The placements
+// come out in ID order.
+vector<Placement> collectPlacements(InputMapType& input, OutputMapType& output)
+{
+    vector<Placement> placed;
+    if(output.empty())
+    {
+        return placed;
+    }
+    InputMapType::iterator rbit = input.begin();
+    for (OutputMapType::iterator it = output.begin(); it != output.end(); ++it)
+    {
+        while(rbit->first < it->first)
+        {
+            ++rbit;
+        }
+        Placement p = {it->first, it->second.first, it->second.second,
+                       rbit->second.length, rbit->second.height};
+        placed.push_back(p);
+    }
+    return placed;
+}
+
+// Runs the backtracking search the way the options ask for
+bool searchWithOptions(const PieceOrder& order, OutputMapType& output, SearchState& state, const SolverOptions& opts)
+{
+    if(opts.restarts)
+    {
+        return restartSearch(order, output, state, opts.seed);
+    }
+    return runSearch(order, output, state);
+}
+
+// One configuration of the backtracking search raced by portfolioSearch()
+struct PortfolioStrategy
+{
+    // place the pieces largest first instead of in ID order
+    bool largestFirst;
+    // scan the board from the far corner instead of from (0, 0)
+    bool mirrored;
+    // run with Luby restarts
+    bool restarts;
+};
+
+const PortfolioStrategy PORTFOLIO[] = {
+    {false, false, false},
+    {true, false, false},
+    {true, true, false},
+    {true, false, true},
+};
+const int PORTFOLIO_SIZE = sizeof(PORTFOLIO) / sizeof(PORTFOLIO[0]);
+
+// What one portfolio worker ended with
+struct PortfolioResult
+{
+    bool found;
+    bool exhausted;
+    std::vector<Placement> placed;
+    std::vector<Placement> best;
+    long long bestArea;
+};
+
+// Body of one portfolio thread. search() rotates the pieces it works on, so
+// the worker builds a private map from the shared piece list and reports
+// its answer as placements. The first worker to settle the instance, by
+// finding a solution or by proving there is none, sets done, which cancels
+// the others at their next node.
+void portfolioWorker(const vector<Rectangle>& pieces, int width, int height, const PortfolioStrategy& strategy,
+                     const SolverOptions& opts, std::chrono::steady_clock::time_point start, std::atomic<bool>& done,
+                     PortfolioResult& result)
+{
+    InputMapType input;
+    for (size_t i = 0; i < pieces.size(); i++)
+    {
+        input.insert(std::make_pair(pieces[i].ID, pieces[i]));
+    }
+    PieceOrder order = idOrder(input);
+    if(strategy.largestFirst)
+    {
+        stable_sort(order.begin(), order.end(), pieceLarger);
+    }
+    SearchState state;
+    state.width = width;
+    state.height = height;
+    state.start = start;
+    state.timeLimitMs = opts.timeLimitMs;
+    state.nodeLimit = opts.nodeLimit;
+    state.cancel = &done;
+    if(strategy.mirrored)
+    {
+        for (int i = width - 1; i >= 0; i--)
+        {
+            state.xOrder.push_back(i);
+        }
+        for (int j = height - 1; j >= 0; j--)
+        {
+            state.yOrder.push_back(j);
+        }
+    }
+    OutputMapType output;
+    if(strategy.restarts)
+    {
+        result.found = restartSearch(order, output, state, opts.seed);
+    }
+    else
+    {
+        result.found = runSearch(order, output, state);
+    }
+    result.exhausted = state.exhausted;
+    result.best = state.best;
+    result.bestArea = state.bestArea;
+    if(result.found)
+    {
+        result.placed = collectPlacements(input, output);
+    }
+    if(result.found || !result.exhausted)
+    {
+        done = true;
+    }
+}
+
+// Races every strategy of PORTFOLIO on its own thread and keeps the answer
+// of whichever settles the instance first. On success solution holds the
+// placements; either way the deepest partial placement seen by any worker
+// is merged into state, and state.exhausted tells whether the budget ran
+// out before anyone settled the instance.
+bool portfolioSearch(const vector<Rectangle>& pieces, const SolverOptions& opts, SearchState& state,
+                     vector<Placement>& solution)
+{
+    std::atomic<bool> done(false);
+    vector<PortfolioResult> results(PORTFOLIO_SIZE);
+    vector<std::thread> workers;
+    for (int i = 0; i < PORTFOLIO_SIZE; i++)
+    {
+        workers.push_back(std::thread(portfolioWorker, std::cref(pieces), state.width, state.height,
+                                      std::cref(PORTFOLIO[i]), std::cref(opts), state.start, std::ref(done),
+                                      std::ref(results[i])));
+    }
+    for (int i = 0; i < PORTFOLIO_SIZE; i++)
+    {
+        workers[i].join();
+    }
+    bool settled = false;
+    for (int i = 0; i < PORTFOLIO_SIZE; i++)
+    {
+        if(results[i].bestArea > state.bestArea)
+        {
+            state.best = results[i].best;
+            state.bestArea = results[i].bestArea;
+        }
+        if(results[i].found)
+        {
+            solution = results[i].placed;
+            return true;
+        }
+        settled = settled || !results[i].exhausted;
+    }
+    state.exhausted = !settled;
+    return false;
+}
+
+// Dual-feasible functions to scale one side of a piece against the board
+// side: kind 0 is Fekete and Schepers' u^(k) with k = param (k = 0 being
+// the identity), kind 1 their f_0 with threshold param, which rounds sides
+// above side - param up to the whole side and sides below param down to 0.
+// Any set of pieces that fits side by side still fits after scaling.
+double dualFeasible(int kind, int param, int size, int side)
+{
+    if(kind == 1)
+    {
+        if(size > side - param)
+        {
+            return 1.0;
+        }
+        return size < param ? 0.0 : (double)size / side;
+    }
+    long long scaled = (long long)(param + 1) * size;
+    if(param == 0 || scaled % side == 0)
+    {
+        return (double)size / side;
+    }
+    return (double)(scaled / side) / param;
+}
+
+// Number of f_0 thresholds tried per side by infeasible()
+const int DFF_THRESHOLDS = 8;
+
+// The dual-feasible functions infeasible() tries on a board side: u^(k) for
+// k up to 4 and f_0 at up to DFF_THRESHOLDS of the piece sides that are at
+// most half of it
+vector<pair<int, int> > dualFeasibleFamily(InputMapType& input, int side)
+{
+    vector<pair<int, int> > family;
+    for (int k = 0; k <= 4; k++)
+    {
+        family.push_back(make_pair(0, k));
+    }
+    set<int> sizes;
+    for (InputMapType::iterator it = input.begin(); it != input.end(); ++it)
+    {
+        if(2 * it->second.length <= side)
+        {
+            sizes.insert(it->second.length);
+        }
+        if(2 * it->second.height <= side)
+        {
+            sizes.insert(it->second.height);
+        }
+    }
+    vector<int> all(sizes.begin(), sizes.end());
+    int step = max(1, (int)all.size() / DFF_THRESHOLDS);
+    for (size_t i = 0; i < all.size(); i += step)
+    {
+        family.push_back(make_pair(1, all[i]));
+    }
+    return family;
+}
+
+/**
+* Cheap certificates that the pieces cannot be packed into a width x height
+* board, checked before any search. In order: a piece that fits in neither
+* orientation, total area, the pieces that must lie across more than half of
+* one side (no two of them fit next to each other that way, so they stack
+* along the other side), and dual-feasible function bounds: scaling both
+* sides of every piece by such functions, in whichever orientation scales
+* smaller, cannot make a packable set exceed the board. Returns true with
+* a human-readable reason if the instance is infeasible.
+*/
+bool infeasible(InputMapType& input, int width, int height, string& reason)
+{
+    if(input.empty())
+    {
+        return false;
+    }
+    std::ostringstream why;
+    long long area = 0;
+    long long wideStack = 0;
+    long long tallStack = 0;
+    for (InputMapType::iterator it = input.begin(); it != input.end(); ++it)
+    {
+        const Rectangle& r = it->second;
+        bool upright = r.length <= width && r.height <= height;
+        bool turned = r.height <= width && r.length <= height;
+        if(!upright && !turned)
+        {
+            why << "piece " << r.ID << " (" << r.length << " x " << r.height
+                << ") fits the " << width << " x " << height << " board in neither orientation";
+            reason = why.str();
+            return true;
+        }
+        area += (long long)r.length * r.height;
+        //the least height the piece adds to the stack of pieces wider than width/2,
+        //if it has to join that stack whichever way round it goes
+        int across = INT_MAX;
+        int along = INT_MAX;
+        bool narrow = (upright && 2 * r.length <= width) || (turned && 2 * r.height <= width);
+        bool low = (upright && 2 * r.height <= height) || (turned && 2 * r.length <= height);
+        if(upright)
+        {
+            across = min(across, r.height);
+            along = min(along, r.length);
+        }
+        if(turned)
+        {
+            across = min(across, r.length);
+            along = min(along, r.height);
+        }
+        if(!narrow)
+        {
+            wideStack += across;
+        }
+        if(!low)
+        {
+            tallStack += along;
+        }
+    }
+    if(area > (long long)width * height)
+    {
+        why << "total piece area " << area << " exceeds the board area " << (long long)width * height;
+        reason = why.str();
+        return true;
+    }
+    if(wideStack > height)
+    {
+        why << "the pieces wider than half the board need a height of " << wideStack
+            << " stacked, more than " << height;
+        reason = why.str();
+        return true;
+    }
+    if(tallStack > width)
+    {
+        why << "the pieces taller than half the board need a width of " << tallStack
+            << " side by side, more than " << width;
+        reason = why.str();
+        return true;
+    }
+    vector<pair<int, int> > fx = dualFeasibleFamily(input, width);
+    vector<pair<int, int> > fy = dualFeasibleFamily(input, height);
+    for (size_t a = 0; a < fx.size(); a++)
+    {
+        for (size_t b = 0; b < fy.size(); b++)
+        {
+            double total = 0;
+            for (InputMapType::iterator it = input.begin(); it != input.end(); ++it)
+            {
+                const Rectangle& r = it->second;
+                double best = 2.0;
+                if(r.length <= width && r.height <= height)
+                {
+                    best = dualFeasible(fx[a].first, fx[a].second, r.length, width) *
+                           dualFeasible(fy[b].first, fy[b].second, r.height, height);
+                }
+                if(r.height <= width && r.length <= height)
+                {
+                    best = min(best, dualFeasible(fx[a].first, fx[a].second, r.height, width) *
+                                     dualFeasible(fy[b].first, fy[b].second, r.length, height));
+                }
+                total += best;
+            }
+            //leave some room for rounding before calling it a certificate
+            if(total > 1.0 + 1e-9)
+            {
+                why << "dual-feasible bound: the scaled pieces cover " << total << " of the board";
+                reason = why.str();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Lower bound on the height of a strip of the given width, or -1 if some
+// piece fits in neither orientation. Combines the area bound, the tallest
+// piece, and the pieces too wide to sit next to each other (both sides
+// over width/2), which have to be stacked.
+int stripLowerBound(InputMapType& input, int width)
+{
+    if(input.empty())
+    {
+        return 0;
+    }
+    long long area = 0;
+    int tallest = 0;
+    long long stacked = 0;
+    for (InputMapType::iterator it = input.begin(); it != input.end(); ++it)
+    {
+        int shortSide = min(it->second.length, it->second.height);
+        int longSide = max(it->second.length, it->second.height);
+        if(shortSide > width)
+        {
+            return -1;
+        }
+        //the lowest the piece can be while still fitting across the strip
+        int low = longSide <= width ? shortSide : longSide;
+        tallest = max(tallest, low);
+        if(2 * shortSide > width)
+        {
+            stacked += low;
+        }
+        area += (long long)it->second.length * it->second.height;
+    }
+    long long bound = (area + width - 1) / width;
+    bound = max(bound, (long long)tallest);
+    bound = max(bound, stacked);
+    return bound > INT_MAX ? INT_MAX : (int)bound;
+}
+
+bool placementTaller(const Placement& a, const Placement& b)
+{
+    return a.height > b.height;
+}
+
+// Next-fit decreasing-height shelf packing into a strip of the given
+// width. Always succeeds once stripLowerBound() has; gives the upper bound
+// the exact search starts from.
+int shelfPack(InputMapType& input, int width, vector<Placement>& placed)
+{
+    placed.clear();
+    if(input.empty())
+    {
+        return 0;
+    }
+    vector<Placement> pieces;
+    for (InputMapType::iterator it = input.begin(); it != input.end(); ++it)
+    {
+        int shortSide = min(it->second.length, it->second.height);
+        int longSide = max(it->second.length, it->second.height);
+        //lie the piece down if it fits that way
+        Placement p = {it->first, 0, 0, longSide, shortSide};
+        if(longSide > width)
+        {
+            p.length = shortSide;
+            p.height = longSide;
+        }
+        pieces.push_back(p);
+    }
+    sort(pieces.begin(), pieces.end(), placementTaller);
+    int shelfY = 0;
+    int shelfHeight = 0;
+    int x = 0;
+    for (size_t i = 0; i < pieces.size(); i++)
+    {
+        if(x + pieces[i].length > width)
+        {
+            shelfY += shelfHeight;
+            shelfHeight = 0;
+            x = 0;
+        }
+        pieces[i].x = x;
+        pieces[i].y = shelfY;
+        x += pieces[i].length;
+        shelfHeight = max(shelfHeight, pieces[i].height);
+        placed.push_back(pieces[i]);
+    }
+    return shelfY + shelfHeight;
+}
+
+// Decides whether the pieces fit on a width x height board, keeping the
+// placements if they do. nodes counts the search nodes spent so far by the
+// whole optimization, which --node-limit bounds; sets exhausted if the
+// budget ran out first.
+bool fitsBoard(InputMapType& input, int width, int height, const SolverOptions& opts,
+               std::chrono::steady_clock::time_point start, long long& nodes, vector<Placement>& placed,
+               bool& exhausted)
+{
+    string reason;
+    if(infeasible(input, width, height, reason))
+    {
+        return false;
+    }
+    PieceOrder order = idOrder(input);
+    if(opts.heuristic)
+    {
+        vector<int> failed;
+        if(skylinePack(pieceList(input), width, height, placed, failed))
+        {
+            return true;
+        }
+        order = seededOrder(input, placed, failed);
+    }
+    if(opts.nodeLimit > 0 && nodes >= opts.nodeLimit)
+    {
+        exhausted = true;
+        return false;
+    }
+    OutputMapType output;
+    SearchState state;
+    state.width = width;
+    state.height = height;
+    state.timeLimitMs = opts.timeLimitMs;
+    state.nodeLimit = opts.nodeLimit > 0 ? opts.nodeLimit - nodes : 0;
+    state.start = start;
+    bool found = searchWithOptions(order, output, state, opts);
+    nodes += state.nodes;
+    if(found)
+    {
+        placed = collectPlacements(input, output);
+    }
+    exhausted = exhausted || state.exhausted;
+    return found;
+}
+
+// Branch and bound on the height of a strip of the given width. Heights
+// between the lower bound and min(shelf packing, cap) are bisected with
+// search() answering each decision, all drawing on the node count in
+// nodes. Returns the best height found, or -1 if nothing within cap was
+// found.
+int minStripHeight(InputMapType& input, int width, int cap, const SolverOptions& opts,
+                   std::chrono::steady_clock::time_point start, long long& nodes, vector<Placement>& best,
+                   bool& exhausted)
+{
+    int lo = stripLowerBound(input, width);
+    if(lo < 0 || lo > cap)
+    {
+        return -1;
+    }
+    int bestHeight = -1;
+    vector<Placement> shelf;
+    int hi = shelfPack(input, width, shelf);
+    if(opts.heuristic)
+    {
+        //an unbounded skyline packing usually gives a tighter start
+        vector<Placement> sky;
+        vector<int> failed;
+        skylinePack(pieceList(input), width, INT_MAX, sky, failed);
+        int skyHeight = 0;
+        for (size_t i = 0; i < sky.size(); i++)
+        {
+            skyHeight = max(skyHeight, sky[i].y + sky[i].height);
+        }
+        if(skyHeight < hi)
+        {
+            hi = skyHeight;
+            shelf = sky;
+        }
+    }
+    if(hi <= cap)
+    {
+        best = shelf;
+        bestHeight = hi;
+        hi--;
+    }
+    else
+    {
+        hi = cap;
+    }
+    while(lo <= hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        vector<Placement> placed;
+        if(fitsBoard(input, width, mid, opts, start, nodes, placed, exhausted))
+        {
+            best = placed;
+            bestHeight = mid;
+            hi = mid - 1;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return bestHeight;
+}
+
+// Smallest-area enclosing board. Pieces may rotate, so a W x H board is as
+// good as an H x W one and only widths W <= H need to be tried; the scan
+// stops once W*W alone reaches the best area found.
+long long minBoardArea(InputMapType& input, const SolverOptions& opts, std::chrono::steady_clock::time_point start,
+                       vector<Placement>& best, int& bestWidth, int& bestHeight, bool& exhausted)
+{
+    if(input.empty())
+    {
+        best.clear();
+        bestWidth = 0;
+        bestHeight = 0;
+        return 0;
+    }
+    //one node budget for every width tried
+    long long nodes = 0;
+    int minWidth = 0;
+    long long maxWidth = 0;
+    for (InputMapType::iterator it = input.begin(); it != input.end(); ++it)
+    {
+        int shortSide = min(it->second.length, it->second.height);
+        minWidth = max(minWidth, shortSide);
+        maxWidth += shortSide;
+    }
+    long long bestArea = LLONG_MAX;
+    for (long long w = max(minWidth, 1); w <= maxWidth && w * w < bestArea; w++)
+    {
+        //the probes check the clock, but the packings between them do not
+        if(opts.timeLimitMs > 0 && std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start).count() >= opts.timeLimitMs)
+        {
+            exhausted = true;
+            break;
+        }
+        int width = (int)w;
+        int lo = stripLowerBound(input, width);
+        if(lo < 0 || w * max(lo, width) >= bestArea)
+        {
+            continue;
+        }
+        long long cap = bestArea == LLONG_MAX ? INT_MAX : (bestArea - 1) / w;
+        vector<Placement> placed;
+        int height = minStripHeight(input, width, (int)min(cap, (long long)INT_MAX), opts, start, nodes, placed,
+                                    exhausted);
+        if(height >= 0 && w * height < bestArea)
+        {
+            bestArea = w * height;
+            best = placed;
+            bestWidth = width;
+            bestHeight = height;
+        }
+    }
+    return bestArea == LLONG_MAX ? -1 : bestArea;
+}
+
+// Anneals a floorplan from one of the non-grid engines and records its
+// placements and bounding box, marking the result exhausted if a limit cut
+// the annealing short
+template <typename Plan>
+void runAnnealer(Plan& plan, const SolverOptions& opts, SolveResult& result)
+{
+    AnnealSchedule schedule;
+    schedule.timeLimitMs = opts.timeLimitMs;
+    schedule.maxMoves = opts.nodeLimit;
+    std::mt19937 rng(opts.seed);
+    anneal(plan, schedule, rng, &result.exhausted);
+    plan.placements(result.placements);
+    result.complete = true;
+    result.width = plan.getWidth();
+    result.height = plan.getHeight();
+}
+
+// Node budget for each repair step of the large-neighbourhood search
+const long long LNS_REPAIR_NODES = 5000;
+
+// Large-neighbourhood search on a partial packing. Each round picks a random
+// window of the board, frees the pieces lying entirely inside it, and asks
+// search() to fit one of the unplaced pieces plus the freed ones back in,
+// with everything else held fixed and a small node budget. A repair is kept
+// if it covers more area than the pieces it freed. Returns true once every
+// piece is placed.
+bool improvePartial(InputMapType& input, int width, int height, vector<Placement>& placed,
+                    const SolverOptions& opts, std::chrono::steady_clock::time_point start)
+{
+    std::mt19937 rng(opts.seed);
+    PieceOrder all = idOrder(input);
+    for (int round = 0; round < opts.lnsIterations; round++)
+    {
+        std::set<int> placedIDs;
+        for (size_t i = 0; i < placed.size(); i++)
+        {
+            placedIDs.insert(placed[i].ID);
+        }
+        vector<int> unplaced;
+        for (size_t i = 0; i < all.size(); i++)
+        {
+            if(placedIDs.count(all[i]->first) == 0)
+            {
+                unplaced.push_back(all[i]->first);
+            }
+        }
+        if(unplaced.empty())
+        {
+            return true;
+        }
+        //window between a quarter and a half of the board in each direction
+        int wx = max(1, width / 4 + (int)(rng() % (width / 4 + 1)));
+        int wy = max(1, height / 4 + (int)(rng() % (height / 4 + 1)));
+        int x0 = rng() % (width - wx + 1);
+        int y0 = rng() % (height - wy + 1);
+        vector<Placement> fixed;
+        vector<Placement> freed;
+        long long freedArea = 0;
+        for (size_t i = 0; i < placed.size(); i++)
+        {
+            const Placement& p = placed[i];
+            if(p.x >= x0 && p.y >= y0 && p.x + p.length <= x0 + wx && p.y + p.height <= y0 + wy)
+            {
+                freed.push_back(p);
+                freedArea += (long long)p.length * p.height;
+            }
+            else
+            {
+                fixed.push_back(p);
+            }
+        }
+        //the new piece goes first so that any repair at all includes it
+        sort(freed.begin(), freed.end(), placementLarger);
+        PieceOrder order;
+        order.push_back(input.find(unplaced[rng() % unplaced.size()]));
+        for (size_t i = 0; i < freed.size(); i++)
+        {
+            order.push_back(input.find(freed[i].ID));
+        }
+        OutputMapType output;
+        SearchState state;
+        state.width = width;
+        state.height = height;
+        state.nodeLimit = LNS_REPAIR_NODES;
+        state.timeLimitMs = opts.timeLimitMs;
+        state.start = start;
+        bool repaired = runSearch(order, fixed, output, state);
+        if(repaired || state.bestArea > freedArea)
+        {
+            placed = fixed;
+            vector<Placement> refit = repaired ? collectPlacements(input, output) : state.best;
+            placed.insert(placed.end(), refit.begin(), refit.end());
+        }
+        if(state.exhausted && state.nodes <= LNS_REPAIR_NODES)
+        {
+            //out of wall-clock time rather than repair budget
+            break;
+        }
+    }
+    return placed.size() == all.size();
+}
+
+bool rectangleLess(const Rectangle& a, const Rectangle& b)
+{
+    return a.ID < b.ID;
+}
+
+}
+
+SolverOptions::SolverOptions() : timeLimitMs(0), nodeLimit(0), strip(false), minArea(false), heuristic(true),
+    lnsIterations(0), engine("grid"), restarts(false), seed(1), portfolio(false)
+{
+
+}
+
+SolveResult::SolveResult() : complete(false), exhausted(false), width(0), height(0), optimal(false)
+{
+
+}
+
+// The pieces are kept in ID order, the order every mode has always seen
+// them in
+FloorplanSolver::FloorplanSolver(int width, int height, const vector<Rectangle>& pieces,
+                                 const SolverOptions& options) :
+    width_(width), height_(height), pieces_(pieces), options_(options)
+{
+    stable_sort(pieces_.begin(), pieces_.end(), rectangleLess);
+}
+
+const SolveResult& FloorplanSolver::solve()
+{
+    result_ = SolveResult();
+    result_.width = width_;
+    result_.height = height_;
+    if(options_.engine != "grid")
+    {
+        solveEngine();
+    }
+    else if(options_.strip || options_.minArea)
+    {
+        solveOptimization();
+    }
+    else
+    {
+        solveBoard();
+    }
+    return result_;
+}
+
+const SolveResult& FloorplanSolver::result() const
+{
+    return result_;
+}
+
+void FloorplanSolver::solveEngine()
+{
+    if(options_.engine == "bstar")
+    {
+        BStarTree plan(pieces_, width_, height_);
+        runAnnealer(plan, options_, result_);
+    }
+    else if(options_.engine == "seqpair")
+    {
+        SequencePair plan(pieces_, width_, height_);
+        runAnnealer(plan, options_, result_);
+    }
+    else if(options_.engine == "slicing")
+    {
+        SlicingFloorplan plan(pieces_, width_, height_);
+        runAnnealer(plan, options_, result_);
+    }
+}
+
+// Strip packing keeps the board width; min-area looks for the whole board
+void FloorplanSolver::solveOptimization()
+{
+    InputMapType input;
+    for (size_t i = 0; i < pieces_.size(); i++)
+    {
+        input.insert(std::make_pair(pieces_[i].ID, pieces_[i]));
+    }
+    int width = width_;
+    int height = -1;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if(options_.minArea)
+    {
+        minBoardArea(input, options_, start, result_.placements, width, height, result_.exhausted);
+    }
+    else
+    {
+        long long nodes = 0;
+        height = minStripHeight(input, width, INT_MAX, options_, start, nodes, result_.placements, result_.exhausted);
+    }
+    if(height >= 0)
+    {
+        result_.complete = true;
+        result_.width = width;
+        result_.height = height;
+        result_.optimal = !result_.exhausted;
+    }
+}
+
+/**
+* The exact search on the given board: the infeasibility certificates
+* first, then the skyline packing, then the backtracking search seeded with
+* what the skyline managed, and with a budget, repair rounds on whatever
+* partial answer is left.
+*/
+void FloorplanSolver::solveBoard()
+{
+    InputMapType input;
+    for (size_t i = 0; i < pieces_.size(); i++)
+    {
+        input.insert(std::make_pair(pieces_[i].ID, pieces_[i]));
+    }
+    if(infeasible(input, width_, height_, result_.reason))
+    {
+        return;
+    }
+
+    SearchState state;
+    state.width = width_;
+    state.height = height_;
+    state.timeLimitMs = options_.timeLimitMs;
+    state.nodeLimit = options_.nodeLimit;
+    PieceOrder order = idOrder(input);
+
+    //most inputs are loose enough for the skyline packing to solve outright
+    if(options_.heuristic)
+    {
+        vector<Placement> placed;
+        vector<int> failed;
+        if(skylinePack(pieces_, width_, height_, placed, failed))
+        {
+            result_.complete = true;
+            result_.placements = placed;
+            return;
+        }
+        order = seededOrder(input, placed, failed);
+        for (size_t i = 0; i < placed.size(); i++)
+        {
+            state.push(placed[i]);
+        }
+        state.current.clear();
+        state.currentArea = 0;
+    }
+
+    //leave half of the time for the repair rounds when they were asked for,
+    //keeping at least 1 ms since 0 would lift the limit
+    if(options_.lnsIterations > 0 && options_.timeLimitMs > 0)
+    {
+        state.timeLimitMs = max(1LL, options_.timeLimitMs / 2);
+    }
+    bool found;
+    if(options_.portfolio)
+    {
+        found = portfolioSearch(pieces_, options_, state, result_.placements);
+    }
+    else
+    {
+        OutputMapType output;
+        found = searchWithOptions(order, output, state, options_);
+        if(found)
+        {
+            result_.placements = collectPlacements(input, output);
+        }
+    }
+    if(found)
+    {
+        result_.complete = true;
+        return;
+    }
+    result_.placements = state.best;
+    result_.exhausted = state.exhausted;
+    bool anytime = options_.timeLimitMs > 0 || options_.nodeLimit > 0;
+    if(anytime && options_.lnsIterations > 0)
+    {
+        result_.complete = improvePartial(input, width_, height_, result_.placements, options_, state.start);
+    }
+}
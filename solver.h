@@ -0,0 +1,91 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <string>
+#include <vector>
+#include "floorplan.h"
+
+/**
+* How FloorplanSolver goes about a puzzle. Limits of 0 mean unlimited.
+*/
+struct SolverOptions
+{
+    SolverOptions();
+
+    long long timeLimitMs;
+    long long nodeLimit;
+    // minimise the height of a board whose width is fixed
+    bool strip;
+    // minimise the area of the board, ignoring both of its sides
+    bool minArea;
+    // try the skyline packing before the exact search
+    bool heuristic;
+    // destroy-and-repair rounds to run on a partial answer
+    int lnsIterations;
+    // "grid" for the backtracking search, or one of the annealing engines
+    // "bstar", "seqpair" and "slicing"
+    std::string engine;
+    // run the backtracking search with Luby restarts
+    bool restarts;
+    // seed for every randomised part of the solver
+    unsigned seed;
+    // race several search strategies on separate threads
+    bool portfolio;
+};
+
+/**
+* What a solve produced.
+*/
+struct SolveResult
+{
+    SolveResult();
+
+    // every piece was placed
+    bool complete;
+    // the solution, or the placements covering the most area found if it is
+    // not complete
+    std::vector<Placement> placements;
+    // the time or node budget ran out before the solver could finish
+    bool exhausted;
+    // if non-empty, why no solution can exist (found without searching)
+    std::string reason;
+    // the board the placements are for: the one asked for, the one found in
+    // the strip and min-area modes, or the bounding box of an annealed
+    // floorplan
+    int width;
+    int height;
+    // strip and min-area modes: no smaller board can hold the pieces
+    bool optimal;
+};
+
+/**
+* Packs a set of rectangles onto a width x height board, in whichever mode
+* the options pick: the exact backtracking search (with its heuristics,
+* restarts, portfolio and repair rounds), strip or min-area optimisation, or
+* one of the annealing engines. Every solver keeps all of its state to
+* itself, so any number of them can run at once on different threads.
+*/
+class FloorplanSolver
+{
+public:
+    FloorplanSolver(int width, int height, const std::vector<Rectangle>& pieces,
+                    const SolverOptions& options = SolverOptions());
+
+    // Solves the puzzle and returns the outcome, which stays available
+    // through result()
+    const SolveResult& solve();
+    const SolveResult& result() const;
+
+private:
+    void solveEngine();
+    void solveOptimization();
+    void solveBoard();
+
+    int width_;
+    int height_;
+    std::vector<Rectangle> pieces_;
+    SolverOptions options_;
+    SolveResult result_;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "solver.h"
+
+using namespace std;
+
+int failures = 0;
+
+// Solves an instance with no pieces and checks that it comes back complete
+// and empty
+void expectEmpty(const string& name, const SolverOptions& opts)
+{
+    vector<Rectangle> none;
+    FloorplanSolver solver(4, 3, none, opts);
+    const SolveResult& result = solver.solve();
+    if(!result.complete || !result.placements.empty() || !result.reason.empty())
+    {
+        cout << "FAIL: " << name << " on an empty instance" << endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    SolverOptions opts;
+    expectEmpty("default", opts);
+    opts.heuristic = false;
+    expectEmpty("no heuristic", opts);
+    opts.lnsIterations = 3;
+    opts.nodeLimit = 10;
+    expectEmpty("lns", opts);
+
+    opts = SolverOptions();
+    opts.strip = true;
+    expectEmpty("strip", opts);
+    opts = SolverOptions();
+    opts.minArea = true;
+    expectEmpty("min-area", opts);
+    opts = SolverOptions();
+    opts.portfolio = true;
+    expectEmpty("portfolio", opts);
+    opts = SolverOptions();
+    opts.restarts = true;
+    opts.heuristic = false;
+    expectEmpty("restarts", opts);
+    const char* engines[] = {"bstar", "seqpair", "slicing"};
+    for (int i = 0; i < 3; i++)
+    {
+        opts = SolverOptions();
+        opts.engine = engines[i];
+        expectEmpty(engines[i], opts);
+    }
+    if(failures > 0)
+    {
+        return 1;
+    }
+    cout << "solver tests passed" << endl;
+    return 0;
+}
@@ -0,0 +1,334 @@
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "stream.h"
+#include "instance.h"
+#include "binformat.h"
+
+using namespace std;
+
+// Bytes asked for by every read of the input
+const size_t STREAM_READ_SIZE = 1 << 16;
+
+// Instances read but not yet answered, per solving thread, before the
+// reader waits for the writer to catch up
+const size_t STREAM_BACKLOG = 4;
+
+struct StreamJob
+{
+    size_t index;
+    Instance instance;
+};
+
+// What the reader and the pool share. pending holds the instances waiting
+// for a thread, and done the answers waiting for those before them to be
+// written.
+struct StreamQueue
+{
+    StreamQueue() : binary(false), read(0), written(0), finished(false)
+    {
+
+    }
+
+    std::mutex lock;
+    // signalled when a job is queued or the input ends
+    std::condition_variable ready;
+    // signalled when an answer is written
+    std::condition_variable space;
+    std::deque<StreamJob> pending;
+    std::map<size_t, string> done;
+    // the input, and so the output, is in the binary format; set before
+    // the first job is queued
+    bool binary;
+    size_t read;
+    size_t written;
+    bool finished;
+};
+
+// Body of one pool thread: solves queued instances until the input has
+// ended and the queue is empty, writing out every answer that is next in
+// line
+void streamWorker(StreamQueue& queue, const SolverOptions& opts, ResultCache* cache, std::ostream& out)
+{
+    for (;;)
+    {
+        StreamJob job;
+        {
+            std::unique_lock<std::mutex> guard(queue.lock);
+            while(queue.pending.empty() && !queue.finished)
+            {
+                queue.ready.wait(guard);
+            }
+            if(queue.pending.empty())
+            {
+                return;
+            }
+            job.index = queue.pending.front().index;
+            job.instance.width = queue.pending.front().instance.width;
+            job.instance.height = queue.pending.front().instance.height;
+            job.instance.pieces.swap(queue.pending.front().instance.pieces);
+            queue.pending.pop_front();
+        }
+        SolveResult result;
+        //a failure is this instance's answer; left to unwind the thread it
+        //would end the whole process, a daemon with all its connections
+        try
+        {
+            result = solveCached(job.instance, opts, cache);
+        }
+        catch(const std::exception& e)
+        {
+            result = SolveResult();
+            result.reason = string("the solver failed: ") + e.what();
+        }
+        ostringstream os;
+        if(queue.binary)
+        {
+            writeBinaryResult(os, job.instance, opts, result);
+        }
+        else
+        {
+            writeResult(os, job.instance, opts, result);
+        }
+
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.done[job.index] = os.str();
+        bool wrote = false;
+        for (std::map<size_t, string>::iterator it = queue.done.begin();
+             it != queue.done.end() && it->first == queue.written; it = queue.done.erase(it))
+        {
+            if(queue.binary)
+            {
+                out << it->second;
+            }
+            else
+            {
+                writeStreamAnswer(out, it->first, it->second);
+            }
+            queue.written++;
+            wrote = true;
+        }
+        if(wrote)
+        {
+            out.flush();
+            queue.space.notify_one();
+        }
+    }
+}
+
+bool runStream(int fd, const std::string& source, std::ostream& out, const SolverOptions& opts, int threads,
+               std::ostream& errors, ResultCache* cache)
+{
+    if(threads <= 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    //the format is only known once the first bytes are in
+    string buffer;
+    size_t start = 0;
+    size_t offset = 0;
+    int line = 1;
+    bool decided = false;
+    bool binary = false;
+    bool eof = false;
+    bool mustRead = true;
+    // unparsed bytes wanted before parsing again while the input is flowing
+    size_t need = 0;
+    string failure;
+
+    StreamQueue queue;
+    vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        workers.push_back(std::thread(streamWorker, std::ref(queue), std::cref(opts), cache, std::ref(out)));
+    }
+
+    for (;;)
+    {
+        if(mustRead && !eof)
+        {
+            size_t used = buffer.size();
+            buffer.resize(used + STREAM_READ_SIZE);
+            ssize_t got = ::read(fd, &buffer[used], STREAM_READ_SIZE);
+            if(got < 0 && errno == EINTR)
+            {
+                buffer.resize(used);
+                continue;
+            }
+            if(got < 0)
+            {
+                failure = source + ": cannot be read: " + strerror(errno);
+            }
+            buffer.resize(used + (got > 0 ? got : 0));
+            eof = got <= 0;
+            //a short read means the writer has nothing more for now, so
+            //whatever is in may be all there is of the instance
+            mustRead = got == (ssize_t)STREAM_READ_SIZE && buffer.size() - start < need;
+            continue;
+        }
+
+        const char* begin = buffer.data() + start;
+        const char* end = buffer.data() + buffer.size();
+        if(!decided)
+        {
+            if(end - begin < 4 && !eof)
+            {
+                mustRead = true;
+                continue;
+            }
+            binary = isBinaryInstance(begin, end);
+            decided = true;
+        }
+        Instance instance;
+        bool parsed;
+        bool truncated;
+        const char* stop;
+        string error;
+        if(binary)
+        {
+            BinaryInstanceReader reader(begin, end, offset);
+            parsed = reader.next(instance);
+            truncated = reader.truncated();
+            stop = reader.position();
+            error = reader.error().empty() ? "" : source + ": " + reader.error();
+        }
+        else
+        {
+            InstanceParser parser(begin, end, line);
+            parsed = parser.next(instance);
+            truncated = parser.truncated();
+            stop = parser.position();
+            error = parser.error().empty() ? "" : source + ":" + parser.error();
+            //until its line has ended the last number may still be growing
+            if(parsed && !eof && (stop == begin || stop[-1] != '\n'))
+            {
+                parsed = false;
+                truncated = true;
+            }
+        }
+
+        if(parsed)
+        {
+            if(!binary)
+            {
+                line += std::count(begin, stop, '\n');
+            }
+            offset += stop - begin;
+            start += stop - begin;
+            need = 0;
+            std::unique_lock<std::mutex> guard(queue.lock);
+            queue.binary = binary;
+            while(queue.read - queue.written >= STREAM_BACKLOG * threads)
+            {
+                queue.space.wait(guard);
+            }
+            StreamJob job = StreamJob();
+            job.index = queue.read++;
+            queue.pending.push_back(job);
+            queue.pending.back().instance.width = instance.width;
+            queue.pending.back().instance.height = instance.height;
+            queue.pending.back().instance.pieces.swap(instance.pieces);
+            queue.ready.notify_one();
+            guard.unlock();
+            //drop what has been parsed once it is most of the buffer
+            if(start > STREAM_READ_SIZE && start > buffer.size() / 2)
+            {
+                buffer.erase(0, start);
+                start = 0;
+            }
+            continue;
+        }
+        if(error.empty() || truncated)
+        {
+            if(eof)
+            {
+                //a failed read already explains why the input stopped
+                if(failure.empty())
+                {
+                    failure = error;
+                }
+                break;
+            }
+            //reparse only once the input has doubled or the writer pauses,
+            //so a large instance is not parsed over and over
+            need = 2 * (end - begin);
+            mustRead = true;
+            continue;
+        }
+        if(failure.empty())
+        {
+            failure = error;
+        }
+        break;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.finished = true;
+    }
+    queue.ready.notify_all();
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i].join();
+    }
+    //reported only now so that it follows every answer, even when errors
+    //is out itself
+    if(!failure.empty())
+    {
+        errors << failure << endl;
+    }
+    return failure.empty();
+}
+
+FdStreamBuf::FdStreamBuf(int fd) : fd_(fd), buffer_(WRITE_BUFFER_SIZE)
+{
+    setp(&buffer_[0], &buffer_[0] + buffer_.size());
+}
+
+FdStreamBuf::~FdStreamBuf()
+{
+    sync();
+}
+
+int FdStreamBuf::overflow(int c)
+{
+    if(sync() != 0)
+    {
+        return traits_type::eof();
+    }
+    if(c != traits_type::eof())
+    {
+        *pptr() = c;
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int FdStreamBuf::sync()
+{
+    for (const char* p = pbase(); p < pptr(); )
+    {
+        ssize_t put = ::write(fd_, p, pptr() - p);
+        if(put < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(put <= 0)
+        {
+            return -1;
+        }
+        p += put;
+    }
+    setp(&buffer_[0], &buffer_[0] + buffer_.size());
+    return 0;
+}
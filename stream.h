@@ -0,0 +1,48 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "solver.h"
+#include "cache.h"
+
+/**
+* Solves the instances arriving on the file descriptor fd, text or binary,
+* written back to back, and streams the answers to out in input order (as
+* in a batch stream: text answers after "Instance k" lines, binary ones
+* back to back). Each instance is handed to a pool of threads threads (0
+* picks one per core) as soon as it has been read in full, so parsing the
+* next instance overlaps solving this one, and every answer is flushed as
+* soon as those before it are out. Malformed input is reported to errors
+* and stops the reading; the instances before it are still answered, and
+* the error is written after them, prefixed with source. An instance the
+* solver fails on (by throwing) is answered with the failure as its reason.
+* With a cache, instances it already holds are answered from it and the
+* others are added. Returns false if the input was malformed or could not
+* be read.
+*/
+bool runStream(int fd, const std::string& source, std::ostream& out, const SolverOptions& opts, int threads,
+               std::ostream& errors, ResultCache* cache = NULL);
+
+/**
+* A stream buffer writing to a file descriptor, such as a socket, in blocks
+* of WRITE_BUFFER_SIZE.
+*/
+class FdStreamBuf : public std::streambuf
+{
+public:
+    explicit FdStreamBuf(int fd);
+    ~FdStreamBuf();
+
+protected:
+    int overflow(int c);
+    int sync();
+
+private:
+    int fd_;
+    std::vector<char> buffer_;
+};
+
+#endif